@@ -3,16 +3,26 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "compiler.h"
 #include "pool.h"
+#include "jobs.h"
 
 MAP_IMPL(structure_ast)
 MAP_IMPL(function_ast)
 MAP_IMPL(new_type_ast)
 MAP_IMPL(alias_ast)
 MAP_IMPL(constant_ast)
-MAP_IMPL(TOKEN_TYPE_TAG)
 MAP_IMPL(type_ast)
 MAP_IMPL(mono_entry)
 MAP_IMPL(mono_entry_structure)
@@ -26,12 +36,7 @@ issymbol(char c){
 }
 
 ast
-parse(token* const tokens, pool* const mem, uint64_t token_count, char* string_content_buffer, char* err){
-	lexer lex = {
-		.tokens=tokens,
-		.token_count=token_count,
-		.index=0
-	};
+parse(const char* const buffer, uint64_t size_bytes, pool* const mem, interner* const names, uint8_t recover, char* err){
 	ast tree = {
 		.import_c = 0,
 		.func_c = 0,
@@ -45,180 +50,1235 @@ parse(token* const tokens, pool* const mem, uint64_t token_count, char* string_c
 		.monomorphs = mono_entry_map_init(mem),
 		.monomorph_structures = mono_entry_structure_map_init(mem),
 		.lifted_lambdas=0,
-		.string_buffer=string_content_buffer
+		.module_c=1,
+		.names=names,
+		.stats=NULL,
+		.recover=recover
 	};
-	tree.import_v = pool_request(mem, sizeof(token)*MAX_IMPORTS);
-	tree.func_v = pool_request(mem, sizeof(function_ast)*MAX_FUNCTIONS);
-	tree.new_type_v = pool_request(mem, sizeof(new_type_ast)*MAX_ALIASES);
-	tree.alias_v = pool_request(mem, sizeof(alias_ast)*MAX_ALIASES);
-	tree.const_v = pool_request(mem, sizeof(constant_ast)*MAX_ALIASES);
-	add_to_tree(&tree, &lex, mem, err);
+	tree.import_v = node_array(mem, token, MAX_IMPORTS);
+	tree.func_v = NULL;
+	tree.new_type_v = NULL;
+	tree.alias_v = NULL;
+	tree.const_v = NULL;
+	tree.module_v = malloc(sizeof(module)*(MAX_IMPORTS+1));
+	module* root = &tree.module_v[0];
+	*root = (module){
+		.mem=mem,
+		.decl_v=NULL,
+		.decl_c=0,
+		.decl_capacity=0,
+		.import_c=0,
+		.cache=NULL,
+		.opened=1,
+		.merged=1,
+		.diag={.diag_v=NULL, .diag_c=0, .diag_capacity=0},
+		.lines={.line_v=NULL, .line_c=0},
+		.err="\0"
+	};
+	// the root source belongs to the caller, it is only kept here for module_locate
+	root->source = (source_file){.buffer=(char*)buffer, .size=size_bytes, .capacity=0, .mapped=0};
+	root->lex = lex_init(buffer, size_bytes, names, 1);
+	root->lex.diag = recover == 1 ? &root->diag : NULL;
+	// module_c grows as imports are found
+	for (uint32_t i = 0;i<tree.module_c;++i){
+		if (tree.module_v[i].opened == 1){
+			module_discover(&tree, &tree.module_v[i]);
+		}
+	}
+	names->locking = tree.module_c > 1;
+	parse_workers workers = {.tree=&tree, .map=mem->map};
+	for (uint32_t i = 0;i<MAX_WORKERS;++i){
+		workers.arena_v[i] = (pool){.tag=NO_POOL};
+	}
+	jobs_run_workers(module_parse_job, module_worker_enter, module_worker_leave, &workers, tree.module_c, jobs_workers());
+	names->locking = 0;
+	// imported declarations live on in the worker arenas, the compile pool owns them from here and releases them on reset
+	for (uint32_t i = 0;i<MAX_WORKERS;++i){
+		pool_adopt(mem, &workers.arena_v[i]);
+	}
+	for (uint32_t i = 1;i<tree.module_c;++i){
+		tree.module_v[i].mem = NULL;
+	}
+	module_merge(&tree, root, mem, err);
 	return tree;
 }
 
+module*
+module_find(ast* const tree, token name){
+	for (uint32_t i = 1;i<tree->module_c;++i){
+		if (tree->module_v[i].name.sym == name.sym){
+			return &tree->module_v[i];
+		}
+	}
+	if (tree->module_c > MAX_IMPORTS){
+		return NULL;
+	}
+	module* m = &tree->module_v[tree->module_c];
+	tree->module_c += 1;
+	*m = (module){
+		.name=name,
+		.mem=NULL,
+		.decl_v=NULL,
+		.decl_c=0,
+		.decl_capacity=0,
+		.import_c=0,
+		.cache=NULL,
+		.opened=0,
+		.merged=0,
+		.diag={.diag_v=NULL, .diag_c=0, .diag_capacity=0},
+		.lines={.line_v=NULL, .line_c=0},
+		.err="\0"
+	};
+	char file_cstr[TOKEN_MAX+4];
+	snprintf(file_cstr, TOKEN_MAX+4, "%.*s.ka", (int)name.len, name.string);
+	if (source_open(&m->source, file_cstr) != 0){
+		snprintf(m->err, ERROR_BUFFER, "Could not find module with name '%s'\n", file_cstr);
+		return m;
+	}
+	m->opened = 1;
+	m->key = hash_image_key(m->source.buffer, m->source.size);
+	char path[CACHE_PATH_MAX];
+	cache_path(path, m->key);
+	m->cache = image_load(path, m->key, tree->names, tree->module_c);
+	if (m->cache != NULL){
+		utimensat(AT_FDCWD, path, NULL, 0);
+		image_header* header = (image_header*)m->cache;
+		m->decl_c = header->root_c;
+		m->decl_capacity = header->root_c;
+		m->decl_v = malloc(sizeof(declaration_ast)*m->decl_capacity);
+		memcpy(m->decl_v, m->cache+header->root, sizeof(declaration_ast)*m->decl_c);
+		m->lex = (lexer){.tokens=NULL, .group_end=NULL, .capacity=0, .chunk_v=NULL, .chunk_c=0, .chunk_index=0, .err="\0"};
+		return m;
+	}
+	m->lex = lex_init(m->source.buffer, m->source.size, tree->names, tree->module_c);
+	m->lex.diag = tree->recover == 1 ? &m->diag : NULL;
+	return m;
+}
+
 void
-add_to_tree(ast* const tree, lexer* const lex, pool* const mem, char* err){
-	token tok;
-	// parse imports
-	for (;lex->index < lex->token_count;++lex->index){
-		tok = lex->tokens[lex->index];
+module_discover(ast* const tree, module* const m){
+	if (m->cache != NULL){
+		image_header* header = (image_header*)m->cache;
+		token* import_v = (token*)(m->cache+header->import);
+		for (uint64_t i = 0;i<header->import_c;++i){
+			if (module_import(tree, m, import_v[i]) != 0){
+				return;
+			}
+		}
+		return;
+	}
+	lexer* const lex = &m->lex;
+	for (;lex_more(lex);++lex->index){
+		token tok = lex_token(lex, lex->index);
 		if (tok.type != TOKEN_IMPORT){
 			break;
 		}
-		if (tree->import_c >= MAX_IMPORTS){
-			snprintf(err, ERROR_BUFFER, "too many imports\n");
+		token filename = lex_token(lex, ++lex->index);
+		if (filename.type != TOKEN_IDENTIFIER){
+			snprintf(m->err, ERROR_BUFFER, " <!> Parsing Error : Tried to import non identifier: '%.*s'\n", (int)filename.len, filename.string);
 			return;
 		}
-		parse_import(tree, lex, mem, err);
-		if (*err != 0){
+		token semi = lex_token(lex, ++lex->index);
+		if (semi.type != TOKEN_SEMI){
+			snprintf(m->err, ERROR_BUFFER, " <!> Parsing Error at : Expected ; after import %.*s, found '%.*s'\n", (int)filename.len, filename.string, (int)semi.len, semi.string);
+			return;
+		}
+		if (module_import(tree, m, filename) != 0){
 			return;
 		}
 	}
-	if (tok.type == TOKEN_EOF){
+}
+
+void
+module_worker_enter(void* const arg, uint32_t worker){
+	parse_workers* const workers = arg;
+	pool_local_set(&workers->arena_v[worker]);
+}
+
+void
+module_worker_leave(void* const arg, uint32_t worker){
+	pool_local_set(NULL);
+}
+
+// the root module parses into the compile pool, imports into the arena of whichever worker takes them
+void
+module_parse_job(void* const arg, uint32_t index){
+	parse_workers* const workers = arg;
+	ast* const tree = workers->tree;
+	module* const m = &tree->module_v[index];
+	if (m->opened == 0 || m->err[0] != '\0' || m->cache != NULL){
 		return;
 	}
-	// parse actual code
-	for (;lex->index < lex->token_count;tok=lex->tokens[++lex->index]){
+	if (index != 0){
+		pool* const local = pool_local();
+		if (local->tag == NO_POOL){
+			*local = pool_map(POOL_SIZE, POOL_DYNAMIC, workers->map);
+			pool_segments(local, ARENA_COUNT, ARENA_SIZE);
+		}
+		if (local->tag == NO_POOL){
+			snprintf(m->err, ERROR_BUFFER, " <!> Out of memory\n");
+			return;
+		}
+		m->mem = local;
+	}
+	parse_declarations(m);
+	if (index != 0 && m->err[0] == '\0' && m->lex.err[0] == '\0' && m->diag.diag_c == 0){
+		cache_store(tree, m);
+	}
+}
+
+void
+parse_declarations(module* const m){
+	lexer* const lex = &m->lex;
+	pool* const mem = m->mem;
+	char* err = m->err;
+	token tok = lex_token(lex, lex->index);
+	for (;lex_more(lex);tok=lex_token(lex, ++lex->index)){
 		if (tok.type == TOKEN_EOF){
 			return;
 		}
+		lex_release(lex);
+		uint64_t first = lex->index;
+		declaration_ast decl;
 		if (tok.type == TOKEN_TYPE){
-			new_type_ast a = parse_new_type(lex, mem, err);
-			if (*err != 0){
-				return;
-			}
-			tree->new_type_v[tree->new_type_c] = a;
-			uint8_t collision = new_type_ast_map_insert(&tree->types, tree->new_type_v[tree->new_type_c].name.string, &tree->new_type_v[tree->new_type_c]);
-			if (collision == 1){
-				snprintf(err, ERROR_BUFFER, " <!> Type '%s' defined multiple times\n", tree->new_type_v[tree->new_type_c].name.string);
-			}
-			else if (function_ast_map_access(&tree->functions, tree->new_type_v[tree->new_type_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Type '%s' defined prior as function\n", tree->new_type_v[tree->new_type_c].name.string);
-			}
-			else if (alias_ast_map_access(&tree->aliases, tree->new_type_v[tree->new_type_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Type '%s' defined prior as alias\n", tree->new_type_v[tree->new_type_c].name.string);
-			}
-			else if (constant_ast_map_access(&tree->constants, tree->new_type_v[tree->new_type_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Type '%s' defined prior as constant\n", tree->new_type_v[tree->new_type_c].name.string);
-			}
-			tree->new_type_c += 1;
+			decl.tag = TYPE_DECLARATION;
+			decl.data.new_type = parse_new_type(lex, mem, err);
 		}
 		else if (tok.type == TOKEN_ALIAS){
-			alias_ast a = parse_new_type(lex, mem, err);
-			if (*err != 0){
-				return;
-			}
-			tree->alias_v[tree->alias_c] = a;
-			uint8_t collision = alias_ast_map_insert(&tree->aliases, tree->alias_v[tree->alias_c].name.string, &tree->alias_v[tree->alias_c]);
-			if (collision == 1){
-				snprintf(err, ERROR_BUFFER, " <!> Alias '%s' defined multiple times\n", tree->alias_v[tree->alias_c].name.string);
-			}
-			else if (function_ast_map_access(&tree->functions, tree->alias_v[tree->alias_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Alias '%s' defined prior as function\n", tree->alias_v[tree->alias_c].name.string);
-			}
-			else if (new_type_ast_map_access(&tree->types, tree->alias_v[tree->alias_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Alias '%s' defined prior as type\n", tree->alias_v[tree->alias_c].name.string);
-			}
-			else if (constant_ast_map_access(&tree->constants, tree->alias_v[tree->alias_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Alias '%s' defined prior as constant\n", tree->alias_v[tree->alias_c].name.string);
-			}
-			tree->alias_c += 1;
+			decl.tag = ALIAS_DECLARATION;
+			decl.data.new_type = parse_new_type(lex, mem, err);
 		}
 		else if (tok.type == TOKEN_CONST){
-			constant_ast cnst = parse_constant(lex, mem, err);
-			if (*err != 0){
-				return;
-			}
-			tree->const_v[tree->const_c] = cnst;
-			uint8_t collision = constant_ast_map_insert(&tree->constants, tree->const_v[tree->const_c].name.string, &tree->const_v[tree->const_c]);
-			if (collision == 1){
-				snprintf(err, ERROR_BUFFER, " <!> Constant '%s' was defined multiple times\n", tree->const_v[tree->const_c].name.string);
-			}
-			else if (function_ast_map_access(&tree->functions, tree->const_v[tree->const_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Constant '%s' defined prior as function\n", tree->const_v[tree->const_c].name.string);
-			}
-			else if (new_type_ast_map_access(&tree->types, tree->const_v[tree->const_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Constant '%s' defined prior as type\n", tree->const_v[tree->const_c].name.string);
-			}
-			else if (alias_ast_map_access(&tree->aliases, tree->const_v[tree->const_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Constant '%s' defined prior as alias\n", tree->const_v[tree->const_c].name.string);
-			}
-			tree->const_c += 1;
+			decl.tag = CONSTANT_DECLARATION;
+			decl.data.constant = parse_constant(lex, mem, err);
 		}
 		else{
-			function_ast f = parse_function(lex, mem, err, 0);
-			if (*err != 0){
-				return;
-			}
-			tree->func_v[tree->func_c] = f;
-			uint8_t collision = function_ast_map_insert(&tree->functions, tree->func_v[tree->func_c].name.string, &tree->func_v[tree->func_c]);
-			if (collision == 1){
-				snprintf(err, ERROR_BUFFER, " <!> Function '%s' defined multiple times\n", tree->func_v[tree->func_c].name.string);
-			}
-			else if (new_type_ast_map_access(&tree->types, tree->func_v[tree->func_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Function '%s' defined prior as type\n", tree->func_v[tree->func_c].name.string);
-			}
-			else if (alias_ast_map_access(&tree->aliases, tree->func_v[tree->func_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Function '%s' defined prior as alias\n", tree->func_v[tree->func_c].name.string);
+			decl.tag = FUNCTION_DECLARATION;
+			decl.data.function = parse_function(lex, mem, err, 0);
+		}
+		if (*err != 0){
+			if (parse_recover(lex, err, first, TOKEN_EOF) == 1){
+				continue;
 			}
-			else if (constant_ast_map_access(&tree->constants, tree->func_v[tree->func_c].name.string) != NULL){
-				snprintf(err, ERROR_BUFFER, " <!> Function '%s' defined prior as constant\n", tree->func_v[tree->func_c].name.string);
+			return;
+		}
+		if (m->decl_c == m->decl_capacity){
+			m->decl_capacity = m->decl_capacity == 0 ? MODULE_DECLARATION_CHUNK : m->decl_capacity*2;
+			m->decl_v = realloc(m->decl_v, sizeof(declaration_ast)*m->decl_capacity);
+		}
+		m->decl_v[m->decl_c] = decl;
+		m->decl_c += 1;
+	}
+}
+
+// merges in the same depth first order a serial front end would have visited modules in
+void
+module_merge(ast* const tree, module* const m, pool* const mem, char* err){
+	for (uint32_t i = 0;i<m->import_c;++i){
+		if (tree->import_c >= MAX_IMPORTS){
+			snprintf(err, ERROR_BUFFER, "too many imports\n");
+			return;
+		}
+		module* imported = &tree->module_v[m->import_v[i]];
+		if (imported->merged == 1){
+			continue;
+		}
+		imported->merged = 1;
+		tree->import_v[tree->import_c] = imported->name;
+		tree->import_c += 1;
+		if (imported->opened == 0){
+			strncpy(err, imported->err, ERROR_BUFFER);
+			return;
+		}
+		module_merge(tree, imported, mem, err);
+		if (*err != 0){
+			return;
+		}
+	}
+	for (uint32_t i = 0;i<m->decl_c && *err == 0;++i){
+		add_declaration(tree, &m->decl_v[i], mem, err);
+	}
+	if (*err == 0){
+		strncpy(err, m->err, ERROR_BUFFER);
+	}
+	if (m->lex.err[0] != '\0'){
+		strncpy(err, m->lex.err, ERROR_BUFFER);
+	}
+}
+
+void
+add_declaration(ast* const tree, declaration_ast* const decl, pool* const mem, char* err){
+	uint8_t collision;
+	switch (decl->tag){
+	case TYPE_DECLARATION:
+		new_type_ast* new_type = declaration_push(mem, new_type_ast, tree->new_type_v, tree->new_type_c);
+		*new_type = decl->data.new_type;
+		collision = new_type_ast_map_insert(&tree->types, new_type->name.sym, new_type);
+		if (collision == 1){
+			snprintf(err, ERROR_BUFFER, " <!> Type '%.*s' defined multiple times\n", (int)new_type->name.len, new_type->name.string);
+		}
+		else if (function_ast_map_access(&tree->functions, new_type->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Type '%.*s' defined prior as function\n", (int)new_type->name.len, new_type->name.string);
+		}
+		else if (alias_ast_map_access(&tree->aliases, new_type->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Type '%.*s' defined prior as alias\n", (int)new_type->name.len, new_type->name.string);
+		}
+		else if (constant_ast_map_access(&tree->constants, new_type->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Type '%.*s' defined prior as constant\n", (int)new_type->name.len, new_type->name.string);
+		}
+		return;
+	case ALIAS_DECLARATION:
+		alias_ast* alias = declaration_push(mem, alias_ast, tree->alias_v, tree->alias_c);
+		*alias = decl->data.new_type;
+		collision = alias_ast_map_insert(&tree->aliases, alias->name.sym, alias);
+		if (collision == 1){
+			snprintf(err, ERROR_BUFFER, " <!> Alias '%.*s' defined multiple times\n", (int)alias->name.len, alias->name.string);
+		}
+		else if (function_ast_map_access(&tree->functions, alias->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Alias '%.*s' defined prior as function\n", (int)alias->name.len, alias->name.string);
+		}
+		else if (new_type_ast_map_access(&tree->types, alias->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Alias '%.*s' defined prior as type\n", (int)alias->name.len, alias->name.string);
+		}
+		else if (constant_ast_map_access(&tree->constants, alias->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Alias '%.*s' defined prior as constant\n", (int)alias->name.len, alias->name.string);
+		}
+		return;
+	case CONSTANT_DECLARATION:
+		constant_ast* constant = declaration_push(mem, constant_ast, tree->const_v, tree->const_c);
+		*constant = decl->data.constant;
+		collision = constant_ast_map_insert(&tree->constants, constant->name.sym, constant);
+		if (collision == 1){
+			snprintf(err, ERROR_BUFFER, " <!> Constant '%.*s' was defined multiple times\n", (int)constant->name.len, constant->name.string);
+		}
+		else if (function_ast_map_access(&tree->functions, constant->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Constant '%.*s' defined prior as function\n", (int)constant->name.len, constant->name.string);
+		}
+		else if (new_type_ast_map_access(&tree->types, constant->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Constant '%.*s' defined prior as type\n", (int)constant->name.len, constant->name.string);
+		}
+		else if (alias_ast_map_access(&tree->aliases, constant->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Constant '%.*s' defined prior as alias\n", (int)constant->name.len, constant->name.string);
+		}
+		return;
+	case FUNCTION_DECLARATION:
+		function_ast* function = declaration_push(mem, function_ast, tree->func_v, tree->func_c);
+		*function = decl->data.function;
+		collision = function_ast_map_insert(&tree->functions, function->name.sym, function);
+		if (collision == 1){
+			snprintf(err, ERROR_BUFFER, " <!> Function '%.*s' defined multiple times\n", (int)function->name.len, function->name.string);
+		}
+		else if (new_type_ast_map_access(&tree->types, function->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Function '%.*s' defined prior as type\n", (int)function->name.len, function->name.string);
+		}
+		else if (alias_ast_map_access(&tree->aliases, function->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Function '%.*s' defined prior as alias\n", (int)function->name.len, function->name.string);
+		}
+		else if (constant_ast_map_access(&tree->constants, function->name.sym) != NULL){
+			snprintf(err, ERROR_BUFFER, " <!> Function '%.*s' defined prior as constant\n", (int)function->name.len, function->name.string);
+		}
+		return;
+	}
+}
+
+void
+close_modules(ast* const tree){
+	for (uint32_t i = 0;i<tree->module_c;++i){
+		module* m = &tree->module_v[i];
+		free(m->decl_v);
+		free(m->diag.diag_v);
+		free(m->lines.line_v);
+		if (i == 0){
+			lex_close(&m->lex);
+			continue;
+		}
+		free(m->cache);
+		if (m->opened == 1){
+			lex_close(&m->lex);
+			source_close(&m->source);
+		}
+	}
+	free(tree->module_v);
+	tree->module_v = NULL;
+	tree->module_c = 0;
+}
+
+// {0, 0} for positions the compiler made up, the module's line index is built on first use
+source_location
+module_locate(ast* const tree, source_pos pos){
+	if (pos.file == 0 || pos.file > tree->module_c){
+		return (source_location){.line=0, .col=0};
+	}
+	module* const m = &tree->module_v[pos.file-1];
+	if (m->lines.line_v == NULL){
+		line_index_build(&m->lines, m->source.buffer, m->source.size);
+	}
+	return line_index_locate(&m->lines, pos.offset);
+}
+
+uint8_t
+module_import(ast* const tree, module* const m, token name){
+	module* imported = module_find(tree, name);
+	if (imported == NULL){
+		snprintf(m->err, ERROR_BUFFER, "Could not import module '%.*s', more than %u modules\n", (int)name.len, name.string, MAX_IMPORTS);
+		return 1;
+	}
+	if (imported->opened == 0){
+		snprintf(m->err, ERROR_BUFFER, "Could not find module with name '%.*s.ka'\n", (int)name.len, name.string);
+		return 1;
+	}
+	if (m->import_c >= MAX_IMPORTS){
+		snprintf(m->err, ERROR_BUFFER, "Could not import module '%.*s', more than %u imports\n", (int)name.len, name.string, MAX_IMPORTS);
+		return 1;
+	}
+	m->import_v[m->import_c] = imported-tree->module_v;
+	m->import_c += 1;
+	return 0;
+}
+
+image
+image_init(void){
+	image img = {
+		.buffer=malloc(IMAGE_CHUNK),
+		.size=0,
+		.capacity=IMAGE_CHUNK,
+		.reloc_v=NULL,
+		.reloc_c=0,
+		.reloc_capacity=0,
+		.token_v=NULL,
+		.token_c=0,
+		.token_capacity=0,
+		.pos_v=NULL,
+		.pos_c=0,
+		.pos_capacity=0
+	};
+	// position 0 holds the header, so it doubles as the null position for walkers
+	image_reserve(&img, sizeof(image_header));
+	return img;
+}
+
+void
+image_free(image* const img){
+	free(img->buffer);
+	free(img->reloc_v);
+	free(img->token_v);
+	free(img->pos_v);
+	img->buffer = NULL;
+	img->reloc_v = NULL;
+	img->token_v = NULL;
+	img->pos_v = NULL;
+}
+
+uint64_t
+image_reserve(image* const img, uint64_t size){
+	uint64_t pos = (img->size+7) & ~7ULL;
+	if (pos+size > img->capacity){
+		while (pos+size > img->capacity){
+			img->capacity *= 2;
+		}
+		img->buffer = realloc(img->buffer, img->capacity);
+	}
+	memset(img->buffer+img->size, 0, (pos+size)-img->size);
+	img->size = pos+size;
+	return pos;
+}
+
+uint64_t
+image_bytes(image* const img, const void* const data, uint64_t size){
+	uint64_t pos = image_reserve(img, size);
+	memcpy(img->buffer+pos, data, size);
+	return pos;
+}
+
+void
+image_mark(uint64_t** const pos_v, uint64_t* const pos_c, uint64_t* const pos_capacity, uint64_t pos){
+	if (*pos_c == *pos_capacity){
+		*pos_capacity = *pos_capacity == 0 ? IMAGE_CHUNK : *pos_capacity*2;
+		*pos_v = realloc(*pos_v, sizeof(uint64_t)**pos_capacity);
+	}
+	(*pos_v)[*pos_c] = pos;
+	*pos_c += 1;
+}
+
+void
+image_link(image* const img, uint64_t field, uint64_t target){
+	*IMAGE_AT(img, field, int64_t) = (int64_t)target-(int64_t)field;
+	image_mark(&img->reloc_v, &img->reloc_c, &img->reloc_capacity, field);
+}
+
+// copies the pointed to data into the image and links field to it, returns 0 for null
+uint64_t
+image_pointer(image* const img, uint64_t field, const void* const data, uint64_t size){
+	if (data == NULL){
+		*IMAGE_AT(img, field, int64_t) = 0;
+		return 0;
+	}
+	uint64_t target = image_bytes(img, data, size);
+	image_link(img, field, target);
+	return target;
+}
+
+void
+image_string(image* const img, uint64_t field, const char* const string, uint64_t len){
+	if (string == NULL){
+		*IMAGE_AT(img, field, int64_t) = 0;
+		return;
+	}
+	uint64_t target = image_reserve(img, len+1);
+	memcpy(img->buffer+target, string, len);
+	image_link(img, field, target);
+}
+
+void
+image_token(image* const img, uint64_t pos){
+	token tok = *IMAGE_AT(img, pos, token);
+	image_string(img, pos+offsetof(token, string), tok.string, tok.len);
+	image_mark(&img->token_v, &img->token_c, &img->token_capacity, pos);
+}
+
+void
+image_tokens(image* const img, uint64_t field, const token* const token_v, uint64_t token_c, uint64_t capacity){
+	if (token_v == NULL || capacity == 0){
+		*IMAGE_AT(img, field, int64_t) = 0;
+		return;
+	}
+	uint64_t target = image_reserve(img, sizeof(token)*capacity);
+	memcpy(img->buffer+target, token_v, sizeof(token)*token_c);
+	image_link(img, field, target);
+	for (uint64_t i = 0;i<token_c;++i){
+		image_token(img, target+(sizeof(token)*i));
+	}
+}
+
+void
+image_type(image* const img, uint64_t pos){
+	if (pos == 0){
+		return;
+	}
+	type_ast type = *IMAGE_AT(img, pos, type_ast);
+	image_mark(&img->pos_v, &img->pos_c, &img->pos_capacity, pos+offsetof(type_ast, pos));
+	image_tokens(img, pos+offsetof(type_ast, param_v), type.param_v, type.param_c, type.param_c);
+	uint64_t target;
+	switch (type.tag){
+	case FUNCTION_TYPE:
+		image_type(img, image_pointer(img, pos+offsetof(type_ast, data.function.left), type.data.function.left, sizeof(type_ast)));
+		image_type(img, image_pointer(img, pos+offsetof(type_ast, data.function.right), type.data.function.right, sizeof(type_ast)));
+		return;
+	case POINTER_TYPE:
+	case PROCEDURE_TYPE:
+		image_type(img, image_pointer(img, pos+offsetof(type_ast, data.pointer), type.data.pointer, sizeof(type_ast)));
+		return;
+	case STRUCT_TYPE:
+		image_structure(img, image_pointer(img, pos+offsetof(type_ast, data.structure), type.data.structure, sizeof(structure_ast)));
+		return;
+	case USER_TYPE:
+		image_token(img, pos+offsetof(type_ast, data.user.user));
+		target = image_pointer(img, pos+offsetof(type_ast, data.user.param_v), type.data.user.param_v, sizeof(type_ast)*type.data.user.param_c);
+		for (uint64_t i = 0;target != 0 && i<type.data.user.param_c;++i){
+			image_type(img, target+(sizeof(type_ast)*i));
+		}
+		return;
+	case BUFFER_TYPE:
+		image_type(img, image_pointer(img, pos+offsetof(type_ast, data.buffer.base), type.data.buffer.base, sizeof(type_ast)));
+		if (type.data.buffer.constant == 1){
+			image_token(img, pos+offsetof(type_ast, data.buffer.const_binding));
+		}
+		return;
+	default:
+		return;
+	}
+}
+
+void
+image_structure(image* const img, uint64_t pos){
+	if (pos == 0){
+		return;
+	}
+	structure_ast structure = *IMAGE_AT(img, pos, structure_ast);
+	uint64_t target = image_pointer(img, pos+offsetof(structure_ast, binding_v), structure.binding_v, sizeof(binding_ast)*structure.binding_c);
+	for (uint64_t i = 0;target != 0 && i<structure.binding_c;++i){
+		image_binding(img, target+(sizeof(binding_ast)*i));
+	}
+	target = image_pointer(img, pos+offsetof(structure_ast, union_v), structure.union_v, sizeof(structure_ast)*structure.union_c);
+	for (uint64_t i = 0;target != 0 && i<structure.union_c;++i){
+		image_structure(img, target+(sizeof(structure_ast)*i));
+	}
+	image_pointer(img, pos+offsetof(structure_ast, encoding), structure.encoding, sizeof(int64_t)*structure.union_c);
+	image_tokens(img, pos+offsetof(structure_ast, tag_v), structure.tag_v, structure.union_c, structure.union_c);
+}
+
+void
+image_binding(image* const img, uint64_t pos){
+	image_type(img, pos+offsetof(binding_ast, type));
+	image_token(img, pos+offsetof(binding_ast, name));
+}
+
+void
+image_statement(image* const img, uint64_t pos){
+	statement_ast statement = *IMAGE_AT(img, pos, statement_ast);
+	switch (statement.tag){
+	case IF_STATEMENT:
+		image_expression(img, image_pointer(img, pos+offsetof(statement_ast, data.if_statement.predicate), statement.data.if_statement.predicate, sizeof(expression_ast)));
+		image_expression(img, image_pointer(img, pos+offsetof(statement_ast, data.if_statement.branch), statement.data.if_statement.branch, sizeof(expression_ast)));
+		image_expression(img, image_pointer(img, pos+offsetof(statement_ast, data.if_statement.alternate), statement.data.if_statement.alternate, sizeof(expression_ast)));
+		break;
+	case FOR_STATEMENT:
+		image_expression(img, image_pointer(img, pos+offsetof(statement_ast, data.for_statement.start), statement.data.for_statement.start, sizeof(expression_ast)));
+		image_expression(img, image_pointer(img, pos+offsetof(statement_ast, data.for_statement.end), statement.data.for_statement.end, sizeof(expression_ast)));
+		image_expression(img, image_pointer(img, pos+offsetof(statement_ast, data.for_statement.inc), statement.data.for_statement.inc, sizeof(expression_ast)));
+		image_expression(img, image_pointer(img, pos+offsetof(statement_ast, data.for_statement.procedure), statement.data.for_statement.procedure, sizeof(expression_ast)));
+		break;
+	default:
+		break;
+	}
+	image_type(img, pos+offsetof(statement_ast, type));
+	if (statement.labeled == 1){
+		image_binding(img, pos+offsetof(statement_ast, label));
+	}
+}
+
+void
+image_literal(image* const img, uint64_t pos){
+	literal_ast lit = *IMAGE_AT(img, pos, literal_ast);
+	image_type(img, pos+offsetof(literal_ast, type));
+	if (lit.tag == STRING_LITERAL){
+		image_string(img, pos+offsetof(literal_ast, data.string.content), lit.data.string.content, lit.data.string.length);
+		return;
+	}
+	uint64_t target = image_pointer(img, pos+offsetof(literal_ast, data.array.member_v), lit.data.array.member_v, sizeof(expression_ast)*lit.data.array.member_c);
+	for (uint64_t i = 0;target != 0 && i<lit.data.array.member_c;++i){
+		image_expression(img, target+(sizeof(expression_ast)*i));
+	}
+}
+
+void
+image_expression(image* const img, uint64_t pos){
+	if (pos == 0){
+		return;
+	}
+	expression_ast expr = *IMAGE_AT(img, pos, expression_ast);
+	image_mark(&img->pos_v, &img->pos_c, &img->pos_capacity, pos+offsetof(expression_ast, pos));
+	uint64_t target;
+	switch (expr.tag){
+	case BLOCK_EXPRESSION:
+	case APPLICATION_EXPRESSION:
+	case PARTIAL_EXPRESSION:
+		image_type(img, pos+offsetof(expression_ast, data.block.type));
+		target = image_pointer(img, pos+offsetof(expression_ast, data.block.expr_v), expr.data.block.expr_v, sizeof(expression_ast)*expr.data.block.expr_c);
+		for (uint64_t i = 0;target != 0 && i<expr.data.block.expr_c;++i){
+			image_expression(img, target+(sizeof(expression_ast)*i));
+		}
+		return;
+	case CLOSURE_EXPRESSION:
+		target = image_pointer(img, pos+offsetof(expression_ast, data.closure.capture_v), expr.data.closure.capture_v, sizeof(binding_ast)*expr.data.closure.capture_c);
+		for (uint64_t i = 0;target != 0 && i<expr.data.closure.capture_c;++i){
+			image_binding(img, target+(sizeof(binding_ast)*i));
+		}
+		target = image_pointer(img, pos+offsetof(expression_ast, data.closure.func), expr.data.closure.func, sizeof(function_ast));
+		if (target != 0){
+			image_function(img, target);
+		}
+		return;
+	case STATEMENT_EXPRESSION:
+		image_statement(img, pos+offsetof(expression_ast, data.statement));
+		return;
+	case BINDING_EXPRESSION:
+	case VALUE_EXPRESSION:
+		image_binding(img, pos+offsetof(expression_ast, data.binding));
+		return;
+	case LITERAL_EXPRESSION:
+		image_literal(img, pos+offsetof(expression_ast, data.literal));
+		return;
+	case DEREF_EXPRESSION:
+	case ACCESS_EXPRESSION:
+	case RETURN_EXPRESSION:
+	case REF_EXPRESSION:
+		image_expression(img, image_pointer(img, pos+offsetof(expression_ast, data.deref), expr.data.deref, sizeof(expression_ast)));
+		return;
+	case LAMBDA_EXPRESSION:
+		image_type(img, pos+offsetof(expression_ast, data.lambda.type));
+		image_tokens(img, pos+offsetof(expression_ast, data.lambda.argv), expr.data.lambda.argv, expr.data.lambda.argc, expr.data.lambda.argc);
+		image_expression(img, image_pointer(img, pos+offsetof(expression_ast, data.lambda.expression), expr.data.lambda.expression, sizeof(expression_ast)));
+		return;
+	case CAST_EXPRESSION:
+		image_expression(img, image_pointer(img, pos+offsetof(expression_ast, data.cast.target), expr.data.cast.target, sizeof(expression_ast)));
+		image_type(img, pos+offsetof(expression_ast, data.cast.type));
+		return;
+	case SIZEOF_EXPRESSION:
+		image_type(img, pos+offsetof(expression_ast, data.size_of.type));
+		image_expression(img, image_pointer(img, pos+offsetof(expression_ast, data.size_of.target), expr.data.size_of.target, sizeof(expression_ast)));
+		return;
+	case NOP_EXPRESSION:
+		return;
+	}
+}
+
+void
+image_function(image* const img, uint64_t pos){
+	image_expression(img, pos+offsetof(function_ast, expression));
+	image_type(img, pos+offsetof(function_ast, type));
+	image_token(img, pos+offsetof(function_ast, name));
+}
+
+void
+image_declaration(image* const img, uint64_t pos){
+	switch (IMAGE_AT(img, pos, declaration_ast)->tag){
+	case TYPE_DECLARATION:
+	case ALIAS_DECLARATION:
+		image_binding(img, pos+offsetof(declaration_ast, data.new_type));
+		return;
+	case CONSTANT_DECLARATION:
+		image_binding(img, pos+offsetof(declaration_ast, data.constant.value));
+		image_token(img, pos+offsetof(declaration_ast, data.constant.name));
+		return;
+	case FUNCTION_DECLARATION:
+		image_function(img, pos+offsetof(declaration_ast, data.function));
+		return;
+	}
+}
+
+// writes through a temporary file so concurrent compiles never observe a partial image
+uint8_t
+image_write(image* const img, const char* const filename){
+	uint64_t reloc = image_bytes(img, img->reloc_v, sizeof(uint64_t)*img->reloc_c);
+	uint64_t tok = image_bytes(img, img->token_v, sizeof(uint64_t)*img->token_c);
+	uint64_t pos = image_bytes(img, img->pos_v, sizeof(uint64_t)*img->pos_c);
+	image_header* header = IMAGE_AT(img, 0, image_header);
+	header->magic = IMAGE_MAGIC;
+	header->size = img->size;
+	header->reloc = reloc;
+	header->reloc_c = img->reloc_c;
+	header->token = tok;
+	header->token_c = img->token_c;
+	header->pos = pos;
+	header->pos_c = img->pos_c;
+	char temp[CACHE_PATH_MAX+8];
+	snprintf(temp, CACHE_PATH_MAX+8, "%s.XXXXXX", filename);
+	int fd = mkstemp(temp);
+	if (fd == -1){
+		return 1;
+	}
+	for (uint64_t written = 0;written<img->size;){
+		ssize_t write_bytes = write(fd, img->buffer+written, img->size-written);
+		if (write_bytes <= 0){
+			close(fd);
+			unlink(temp);
+			return 1;
+		}
+		written += write_bytes;
+	}
+	close(fd);
+	if (rename(temp, filename) != 0){
+		unlink(temp);
+		return 1;
+	}
+	return 0;
+}
+
+// reads an image and resolves its relative pointers and symbols, NULL when missing, stale or malformed
+// the same source can be a different module in another program, so every position is moved to file
+uint8_t*
+image_load(const char* const filename, uint64_t key, interner* const names, uint16_t file){
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1){
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) == -1 || (uint64_t)info.st_size < sizeof(image_header)){
+		close(fd);
+		return NULL;
+	}
+	uint64_t size = info.st_size;
+	uint8_t* buffer = malloc(size);
+	uint64_t read_total = 0;
+	while (buffer != NULL && read_total<size){
+		ssize_t read_bytes = read(fd, buffer+read_total, size-read_total);
+		if (read_bytes <= 0){
+			break;
+		}
+		read_total += read_bytes;
+	}
+	close(fd);
+	if (buffer == NULL){
+		return NULL;
+	}
+	image_header* header = (image_header*)buffer;
+	if (read_total != size
+	 || header->magic != IMAGE_MAGIC
+	 || header->key != key
+	 || header->size != size
+	 || header->reloc > size || header->reloc_c > (size-header->reloc)/sizeof(uint64_t)
+	 || header->token > size || header->token_c > (size-header->token)/sizeof(uint64_t)
+	 || header->pos > size || header->pos_c > (size-header->pos)/sizeof(uint64_t)
+	 || header->import > size || header->import_c > (size-header->import)/sizeof(token)
+	 || header->root > size || header->root_c > (size-header->root)/sizeof(declaration_ast)){
+		free(buffer);
+		return NULL;
+	}
+	uint64_t* reloc_v = (uint64_t*)(buffer+header->reloc);
+	for (uint64_t i = 0;i<header->reloc_c;++i){
+		uint64_t field = reloc_v[i];
+		if ((field & 7) != 0 || field+sizeof(int64_t) > size){
+			free(buffer);
+			return NULL;
+		}
+		int64_t target = (int64_t)field+*(int64_t*)(buffer+field);
+		if (target <= 0 || (uint64_t)target > size){
+			free(buffer);
+			return NULL;
+		}
+		*(uint8_t**)(buffer+field) = buffer+target;
+	}
+	uint64_t* token_v = (uint64_t*)(buffer+header->token);
+	for (uint64_t i = 0;i<header->token_c;++i){
+		if ((token_v[i] & 7) != 0 || token_v[i]+sizeof(token) > size){
+			free(buffer);
+			return NULL;
+		}
+		token* tok = (token*)(buffer+token_v[i]);
+		if (tok->string == NULL || tok->string+tok->len > (char*)buffer+size){
+			free(buffer);
+			return NULL;
+		}
+		tok->sym = intern(names, tok->string, tok->len);
+	}
+	uint64_t* pos_v = (uint64_t*)(buffer+header->pos);
+	for (uint64_t i = 0;i<header->pos_c;++i){
+		if ((pos_v[i] & 3) != 0 || pos_v[i]+sizeof(source_pos) > size){
+			free(buffer);
+			return NULL;
+		}
+		((source_pos*)(buffer+pos_v[i]))->file = file;
+	}
+	return buffer;
+}
+
+// fnv-1a over the compiler version and module source, any rebuild or edit misses the cache
+uint64_t
+hash_image_key(const char* const buffer, uint64_t size_bytes){
+	const char* version = COMPILER_VERSION;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (uint64_t i = 0;version[i] != '\0';++i){
+		hash = (hash ^ (uint8_t)version[i])*0x100000001b3ULL;
+	}
+	for (uint64_t i = 0;i<size_bytes;++i){
+		hash = (hash ^ (uint8_t)buffer[i])*0x100000001b3ULL;
+	}
+	return (hash ^ size_bytes)*0x100000001b3ULL;
+}
+
+void
+cache_path(char* const path, uint64_t key){
+	snprintf(path, CACHE_PATH_MAX, CACHE_DIRECTORY "/%016" PRIx64 ".kai", key);
+}
+
+// removes images not used for max_age seconds, 0 clears the cache, a hit refreshes its image's modification time
+// images keyed by an older compiler or source are never hit again, so this is what reclaims them
+void
+cache_prune(time_t max_age){
+	DIR* dir = opendir(CACHE_DIRECTORY);
+	if (dir == NULL){
+		return;
+	}
+	time_t now = time(NULL);
+	for (struct dirent* entry = readdir(dir);entry != NULL;entry = readdir(dir)){
+		size_t len = strnlen(entry->d_name, CACHE_PATH_MAX);
+		if (len < 4 || strncmp(entry->d_name+len-4, ".kai", 4) != 0){
+			continue;
+		}
+		char path[CACHE_PATH_MAX];
+		if (snprintf(path, CACHE_PATH_MAX, CACHE_DIRECTORY "/%s", entry->d_name) >= CACHE_PATH_MAX){
+			continue;
+		}
+		struct stat info;
+		if (max_age == 0 || (stat(path, &info) == 0 && now-info.st_mtime > max_age)){
+			unlink(path);
+		}
+	}
+	closedir(dir);
+}
+
+void
+cache_store(ast* const tree, module* const m){
+	image img = image_init();
+	uint64_t import = image_reserve(&img, sizeof(token)*m->import_c);
+	for (uint32_t i = 0;i<m->import_c;++i){
+		*IMAGE_AT(&img, import+(sizeof(token)*i), token) = tree->module_v[m->import_v[i]].name;
+		image_token(&img, import+(sizeof(token)*i));
+	}
+	uint64_t root = image_reserve(&img, sizeof(declaration_ast)*m->decl_c);
+	for (uint32_t i = 0;i<m->decl_c;++i){
+		*IMAGE_AT(&img, root+(sizeof(declaration_ast)*i), declaration_ast) = m->decl_v[i];
+		image_declaration(&img, root+(sizeof(declaration_ast)*i));
+	}
+	image_header* header = IMAGE_AT(&img, 0, image_header);
+	header->key = m->key;
+	header->import = import;
+	header->import_c = m->import_c;
+	header->root = root;
+	header->root_c = m->decl_c;
+	mkdir(CACHE_DIRECTORY, 0755);
+	char path[CACHE_PATH_MAX];
+	cache_path(path, m->key);
+	image_write(&img, path);
+	image_free(&img);
+}
+
+// writes a rolled tree as an image that ast_image_open maps without any fix up, maps are left empty for the reader to rebuild
+uint8_t
+ast_image_write(const ast* const tree, const char* const filename){
+	image img = image_init();
+	uint64_t root = image_bytes(&img, tree, sizeof(ast));
+	ast* const copy = IMAGE_AT(&img, root, ast);
+	memset(&copy->functions, 0, sizeof(function_ast_map));
+	memset(&copy->types, 0, sizeof(new_type_ast_map));
+	memset(&copy->aliases, 0, sizeof(alias_ast_map));
+	memset(&copy->constants, 0, sizeof(constant_ast_map));
+	memset(&copy->monomorphs, 0, sizeof(mono_entry_map));
+	memset(&copy->monomorph_structures, 0, sizeof(mono_entry_structure_map));
+	copy->module_v = NULL;
+	copy->module_c = 0;
+	copy->names = NULL;
+	copy->stats = NULL;
+	image_tokens(&img, root+offsetof(ast, import_v), tree->import_v, tree->import_c, tree->import_c);
+	// declaration lists are arrays of links, each entry is written after the list
+	uint64_t target = image_pointer(&img, root+offsetof(ast, func_v), tree->func_v, sizeof(function_ast*)*tree->func_c);
+	for (uint32_t i = 0;i<tree->func_c;++i){
+		image_function(&img, image_pointer(&img, target+(sizeof(function_ast*)*i), tree->func_v[i], sizeof(function_ast)));
+	}
+	target = image_pointer(&img, root+offsetof(ast, new_type_v), tree->new_type_v, sizeof(new_type_ast*)*tree->new_type_c);
+	for (uint32_t i = 0;i<tree->new_type_c;++i){
+		image_binding(&img, image_pointer(&img, target+(sizeof(new_type_ast*)*i), tree->new_type_v[i], sizeof(new_type_ast)));
+	}
+	target = image_pointer(&img, root+offsetof(ast, alias_v), tree->alias_v, sizeof(alias_ast*)*tree->alias_c);
+	for (uint32_t i = 0;i<tree->alias_c;++i){
+		image_binding(&img, image_pointer(&img, target+(sizeof(alias_ast*)*i), tree->alias_v[i], sizeof(alias_ast)));
+	}
+	target = image_pointer(&img, root+offsetof(ast, const_v), tree->const_v, sizeof(constant_ast*)*tree->const_c);
+	for (uint32_t i = 0;i<tree->const_c;++i){
+		uint64_t constant = image_pointer(&img, target+(sizeof(constant_ast*)*i), tree->const_v[i], sizeof(constant_ast));
+		image_binding(&img, constant+offsetof(constant_ast, value));
+		image_token(&img, constant+offsetof(constant_ast, name));
+	}
+	image_header* header = IMAGE_AT(&img, 0, image_header);
+	header->key = hash_image_key(NULL, 0);
+	header->root = root;
+	header->root_c = 1;
+	uint8_t result = image_write(&img, filename);
+	image_free(&img);
+	return result;
+}
+
+// maps a tree image read only, links are followed with IMAGE_REF, NULL when missing or built by another compiler
+const ast*
+ast_image_open(ast_image* const img, const char* const filename){
+	img->buffer = NULL;
+	img->size = 0;
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1){
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) == -1 || (uint64_t)info.st_size < sizeof(image_header)){
+		close(fd);
+		return NULL;
+	}
+	uint8_t* buffer = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (buffer == MAP_FAILED){
+		return NULL;
+	}
+	const image_header* header = (const image_header*)buffer;
+	if (header->magic != IMAGE_MAGIC
+	 || header->key != hash_image_key(NULL, 0)
+	 || header->size != (uint64_t)info.st_size
+	 || header->root_c != 1
+	 || header->size < sizeof(ast)
+	 || header->root > header->size-sizeof(ast)){
+		munmap(buffer, info.st_size);
+		return NULL;
+	}
+	img->buffer = buffer;
+	img->size = info.st_size;
+	return (const ast*)(buffer+header->root);
+}
+
+void
+ast_image_close(ast_image* const img){
+	if (img->buffer != NULL){
+		munmap(img->buffer, img->size);
+	}
+	img->buffer = NULL;
+	img->size = 0;
+}
+
+const void*
+image_ref(const void* const field){
+	int64_t offset;
+	memcpy(&offset, field, sizeof(int64_t));
+	if (offset == 0){
+		return NULL;
+	}
+	return (const uint8_t*)field+offset;
+}
+
+// follows a link in a live tree, digest walkers take this or image_ref to read a tree in place or out of a mapped image
+const void*
+tree_pointer(const void* const field){
+	return *(const void* const*)field;
+}
+
+void
+digest_mix(tree_digest* const digest, const void* const data, uint64_t size){
+	for (uint64_t i = 0;i<size;++i){
+		digest->hash = (digest->hash ^ ((const uint8_t*)data)[i])*0x100000001b3ULL;
+	}
+}
+
+void
+digest_token(tree_digest* const digest, tree_link link, const token* const tok){
+	const char* string = link(&tok->string);
+	if (string != NULL){
+		digest_mix(digest, string, tok->len);
+	}
+}
+
+void
+digest_type(tree_digest* const digest, tree_link link, const type_ast* const type){
+	if (type == NULL){
+		return;
+	}
+	digest->type_c += 1;
+	digest_mix(digest, &type->tag, sizeof(type->tag));
+	const token* param_v = link(&type->param_v);
+	for (uint32_t i = 0;param_v != NULL && i<type->param_c;++i){
+		digest_token(digest, link, &param_v[i]);
+	}
+	const type_ast* user_v;
+	switch (type->tag){
+	case FUNCTION_TYPE:
+		digest_type(digest, link, link(&type->data.function.left));
+		digest_type(digest, link, link(&type->data.function.right));
+		return;
+	case POINTER_TYPE:
+	case PROCEDURE_TYPE:
+		digest_type(digest, link, link(&type->data.pointer));
+		return;
+	case STRUCT_TYPE:
+		digest_structure(digest, link, link(&type->data.structure));
+		return;
+	case USER_TYPE:
+		digest_token(digest, link, &type->data.user.user);
+		user_v = link(&type->data.user.param_v);
+		for (uint32_t i = 0;user_v != NULL && i<type->data.user.param_c;++i){
+			digest_type(digest, link, &user_v[i]);
+		}
+		return;
+	case BUFFER_TYPE:
+		digest_type(digest, link, link(&type->data.buffer.base));
+		digest_mix(digest, &type->data.buffer.count, sizeof(type->data.buffer.count));
+		if (type->data.buffer.constant == 1){
+			digest_token(digest, link, &type->data.buffer.const_binding);
+		}
+		return;
+	case PRIMITIVE_TYPE:
+		digest_mix(digest, &type->data.primitive, sizeof(type->data.primitive));
+		return;
+	default:
+		return;
+	}
+}
+
+void
+digest_structure(tree_digest* const digest, tree_link link, const structure_ast* const structure){
+	if (structure == NULL){
+		return;
+	}
+	const binding_ast* binding_v = link(&structure->binding_v);
+	for (uint32_t i = 0;binding_v != NULL && i<structure->binding_c;++i){
+		digest_binding(digest, link, &binding_v[i]);
+	}
+	const structure_ast* union_v = link(&structure->union_v);
+	const token* tag_v = link(&structure->tag_v);
+	for (uint32_t i = 0;union_v != NULL && i<structure->union_c;++i){
+		digest_structure(digest, link, &union_v[i]);
+		if (tag_v != NULL){
+			digest_token(digest, link, &tag_v[i]);
+		}
+	}
+}
+
+void
+digest_binding(tree_digest* const digest, tree_link link, const binding_ast* const binding){
+	digest_type(digest, link, &binding->type);
+	digest_token(digest, link, &binding->name);
+}
+
+void
+digest_expression(tree_digest* const digest, tree_link link, const expression_ast* const expr){
+	if (expr == NULL){
+		return;
+	}
+	digest->expression_c += 1;
+	digest_mix(digest, &expr->tag, sizeof(expr->tag));
+	const expression_ast* expr_v;
+	const binding_ast* capture_v;
+	const statement_ast* statement;
+	const literal_ast* lit;
+	const token* argv;
+	switch (expr->tag){
+	case BLOCK_EXPRESSION:
+	case APPLICATION_EXPRESSION:
+	case PARTIAL_EXPRESSION:
+		digest_type(digest, link, &expr->data.block.type);
+		expr_v = link(&expr->data.block.expr_v);
+		for (uint32_t i = 0;expr_v != NULL && i<expr->data.block.expr_c;++i){
+			digest_expression(digest, link, &expr_v[i]);
+		}
+		return;
+	case CLOSURE_EXPRESSION:
+		capture_v = link(&expr->data.closure.capture_v);
+		for (uint32_t i = 0;capture_v != NULL && i<expr->data.closure.capture_c;++i){
+			digest_binding(digest, link, &capture_v[i]);
+		}
+		digest_function(digest, link, link(&expr->data.closure.func));
+		return;
+	case STATEMENT_EXPRESSION:
+		statement = &expr->data.statement;
+		digest_mix(digest, &statement->tag, sizeof(statement->tag));
+		if (statement->tag == IF_STATEMENT){
+			digest_expression(digest, link, link(&statement->data.if_statement.predicate));
+			digest_expression(digest, link, link(&statement->data.if_statement.branch));
+			digest_expression(digest, link, link(&statement->data.if_statement.alternate));
+		}
+		else if (statement->tag == FOR_STATEMENT){
+			digest_expression(digest, link, link(&statement->data.for_statement.start));
+			digest_expression(digest, link, link(&statement->data.for_statement.end));
+			digest_expression(digest, link, link(&statement->data.for_statement.inc));
+			digest_expression(digest, link, link(&statement->data.for_statement.procedure));
+		}
+		digest_type(digest, link, &statement->type);
+		if (statement->labeled == 1){
+			digest_binding(digest, link, &statement->label);
+		}
+		return;
+	case BINDING_EXPRESSION:
+	case VALUE_EXPRESSION:
+		digest_binding(digest, link, &expr->data.binding);
+		return;
+	case LITERAL_EXPRESSION:
+		lit = &expr->data.literal;
+		digest_type(digest, link, &lit->type);
+		if (lit->tag == STRING_LITERAL){
+			const char* content = link(&lit->data.string.content);
+			if (content != NULL){
+				digest_mix(digest, content, lit->data.string.length);
 			}
-			tree->func_c += 1;
+			return;
+		}
+		expr_v = link(&lit->data.array.member_v);
+		for (uint32_t i = 0;expr_v != NULL && i<lit->data.array.member_c;++i){
+			digest_expression(digest, link, &expr_v[i]);
 		}
+		return;
+	case DEREF_EXPRESSION:
+	case ACCESS_EXPRESSION:
+	case RETURN_EXPRESSION:
+	case REF_EXPRESSION:
+		digest_expression(digest, link, link(&expr->data.deref));
+		return;
+	case LAMBDA_EXPRESSION:
+		digest_type(digest, link, &expr->data.lambda.type);
+		argv = link(&expr->data.lambda.argv);
+		for (uint32_t i = 0;argv != NULL && i<expr->data.lambda.argc;++i){
+			digest_token(digest, link, &argv[i]);
+		}
+		digest_expression(digest, link, link(&expr->data.lambda.expression));
+		return;
+	case CAST_EXPRESSION:
+		digest_expression(digest, link, link(&expr->data.cast.target));
+		digest_type(digest, link, &expr->data.cast.type);
+		return;
+	case SIZEOF_EXPRESSION:
+		digest_type(digest, link, &expr->data.size_of.type);
+		digest_expression(digest, link, link(&expr->data.size_of.target));
+		return;
+	case NOP_EXPRESSION:
+		return;
 	}
 }
 
 void
-parse_import(ast* const tree, lexer* const lex, pool* const mem, char* err){
-	token filename = lex->tokens[++lex->index];
-	if (filename.type != TOKEN_IDENTIFIER){
-		snprintf(err, ERROR_BUFFER, " <!> Parsing Error : Tried to import non identifier: '%s'\n", filename.string);
+digest_function(tree_digest* const digest, tree_link link, const function_ast* const func){
+	if (func == NULL){
 		return;
 	}
-	token semi = lex->tokens[++lex->index];
-	if (semi.type != TOKEN_SEMI){
-		snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected ; after import %s, found '%s'\n", filename.string, semi.string);
-		return;
+	digest_expression(digest, link, &func->expression);
+	digest_type(digest, link, &func->type);
+	digest_token(digest, link, &func->name);
+}
+
+// the same walk over a live tree or a mapped image must give the same digest, which is how a written image is checked
+tree_digest
+digest_tree(const ast* const tree, tree_link link){
+	tree_digest digest = {
+		.function_c=tree->func_c,
+		.type_c=0,
+		.expression_c=0,
+		.declaration_c=tree->func_c+tree->new_type_c+tree->alias_c+tree->const_c,
+		.hash=0xcbf29ce484222325ULL
+	};
+	const token* import_v = link(&tree->import_v);
+	for (uint32_t i = 0;import_v != NULL && i<tree->import_c;++i){
+		digest_token(&digest, link, &import_v[i]);
 	}
-	if (already_imported(tree, filename) == 1){
-		return;
+	function_ast* const* func_v = link(&tree->func_v);
+	for (uint32_t i = 0;func_v != NULL && i<tree->func_c;++i){
+		digest_function(&digest, link, link(&func_v[i]));
 	}
-	tree->import_v[tree->import_c] = filename;
-	tree->import_c += 1;
-	char file_cstr[TOKEN_MAX+3];
-	strncpy(file_cstr, filename.string, filename.len);
-	strcat(file_cstr, ".ka");
-	FILE* fd = fopen(file_cstr, "r");
-	if (fd == NULL){
-		snprintf(err, ERROR_BUFFER, "Could not find module with name '%s'\n", file_cstr);
-		return;
+	new_type_ast* const* new_type_v = link(&tree->new_type_v);
+	for (uint32_t i = 0;new_type_v != NULL && i<tree->new_type_c;++i){
+		digest_binding(&digest, link, link(&new_type_v[i]));
 	}
-	uint64_t read_bytes = fread(mem->buffer, sizeof(char), READ_BUFFER_SIZE, fd);
-	fclose(fd);
-	if (read_bytes == READ_BUFFER_SIZE){
-		snprintf(err, ERROR_BUFFER, "file larger than allowed read buffer\n");
-		return;
+	alias_ast* const* alias_v = link(&tree->alias_v);
+	for (uint32_t i = 0;alias_v != NULL && i<tree->alias_c;++i){
+		digest_binding(&digest, link, link(&alias_v[i]));
 	}
-	uint64_t token_count = 0;
-	token* tokens = lex_cstr(mem->buffer, read_bytes, mem, &token_count, &tree->string_buffer, err);
-	if (*err != 0){
-		return;
+	constant_ast* const* const_v = link(&tree->const_v);
+	for (uint32_t i = 0;const_v != NULL && i<tree->const_c;++i){
+		const constant_ast* constant = link(&const_v[i]);
+		digest_binding(&digest, link, &constant->value);
+		digest_token(&digest, link, &constant->name);
 	}
-	lexer nested_lex = {
-		.tokens=tokens,
-		.token_count = token_count,
-		.index=0
-	};
-	add_to_tree(tree, &nested_lex, mem, err);
+	return digest;
+}
+
+void
+show_digest(const char* const label, const tree_digest* const digest){
+	printf("%s: %u declarations, %u functions, %" PRIu64 " expressions, %" PRIu64 " types, digest %016" PRIx64 "\n", label, digest->declaration_c, digest->function_c, digest->expression_c, digest->type_c, digest->hash);
 }
 
+// writes the compiled tree as an image, maps it back and walks both, the two digests only match if every link survived
 uint8_t
-already_imported(ast* const tree, token filename){
-	for (uint32_t i = 0;i<tree->import_c;++i){
-		if (strncmp(tree->import_v[i].string, filename.string, TOKEN_MAX) == 0){
-			return 1;
-		}
+tree_image_check(const ast* const tree, const char* const filename){
+	if (ast_image_write(tree, filename) != 0){
+		fprintf(stderr, "Could not write tree image '%s'\n", filename);
+		return 1;
+	}
+	ast_image img;
+	const ast* mapped = ast_image_open(&img, filename);
+	if (mapped == NULL){
+		fprintf(stderr, "Could not map tree image '%s'\n", filename);
+		return 1;
+	}
+	tree_digest live = digest_tree(tree, tree_pointer);
+	tree_digest stored = digest_tree(mapped, image_ref);
+	show_digest("Tree", &live);
+	show_digest("Image", &stored);
+	ast_image_close(&img);
+	if (live.hash != stored.hash || live.expression_c != stored.expression_c){
+		fprintf(stderr, "Tree image '%s' does not match the compiled tree\n", filename);
+		return 1;
 	}
 	return 0;
 }
@@ -226,41 +1286,45 @@ already_imported(ast* const tree, token filename){
 structure_ast
 parse_struct(lexer* const lex, pool* const mem, char* err){
 	structure_ast outer = {
-		.binding_v=pool_request(mem, sizeof(binding_ast)*MAX_MEMBERS),
+		.binding_v=NULL,
 		.union_v=NULL,
 		.encoding=NULL,
 		.tag_v=NULL,
 		.binding_c=0,
 		.union_c=0
 	};
-	for (token tok = lex->tokens[++lex->index];
-		 lex->index<lex->token_count;
-		 tok=lex->tokens[++lex->index]
+	for (token tok = lex_token(lex, ++lex->index);
+		 lex_more(lex);
+		 tok=lex_token(lex, ++lex->index)
 	){
 		if (tok.type == TOKEN_BRACE_CLOSE){
+			node_trim(mem, binding_ast, outer.binding_v, outer.binding_c);
+			node_trim(mem, structure_ast, outer.union_v, outer.union_c);
+			node_trim(mem, int64_t, outer.encoding, outer.union_c);
+			node_trim(mem, token, outer.tag_v, outer.union_c);
 			return outer;
 		}
-		uint64_t copy = parse_save(lex, mem);
-		type_ast type = parse_type(lex, mem, err, TOKEN_IDENTIFIER, 0);
-		if (*err != 0){
-			parse_load(lex, mem, copy);
-			*err = 0;
-			if (tok.type != TOKEN_IDENTIFIER){
-				snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected identifier for enumerated union member or type for struct member, found '%s'\n", tok.string);
-				return outer;
-			}
+		if (predict_union_member(lex) == 1){
+			outer.union_v = node_vector(mem, structure_ast, outer.union_v, outer.union_c);
+			outer.encoding = node_vector(mem, int64_t, outer.encoding, outer.union_c);
+			outer.tag_v = node_vector(mem, token, outer.tag_v, outer.union_c);
 			if (outer.union_c == 0){
-				outer.union_v = pool_request(mem, sizeof(structure_ast)*MAX_MEMBERS);
-				outer.encoding = pool_request(mem, sizeof(int64_t)*MAX_MEMBERS);
-				outer.tag_v = pool_request(mem, sizeof(token)*MAX_MEMBERS);
 				outer.encoding[0] = 0;
 			}
 			else{
 				outer.encoding[outer.union_c] = outer.encoding[outer.union_c-1]+1;
 			}
 			outer.tag_v[outer.union_c] = tok;
+			outer.union_v[outer.union_c] = (structure_ast){
+				.binding_v=NULL,
+				.union_v=NULL,
+				.encoding=NULL,
+				.tag_v=NULL,
+				.binding_c=0,
+				.union_c=0
+			};
 			outer.union_c += 1;
-			token open = lex->tokens[++lex->index];
+			token open = lex_token(lex, ++lex->index);
 			switch(open.type){
 			case TOKEN_SEMI:
 				break;
@@ -270,92 +1334,93 @@ parse_struct(lexer* const lex, pool* const mem, char* err){
 					return outer;
 				}
 				outer.union_v[outer.union_c-1] = s;
-				token semi = lex->tokens[++lex->index];
+				token semi = lex_token(lex, ++lex->index);
 				if (semi.type == TOKEN_SEMI){
 					break;
 				}
 				if (semi.type != TOKEN_SET){
-					snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected ';' to end union or '=' to set enumerated encoding, found '%s'\n", semi.string);
+					snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected ';' to end union or '=' to set enumerated encoding, found '%.*s'\n", (int)semi.len, semi.string);
 					return outer;
 				}
 			case TOKEN_SET:
-				token encoding = lex->tokens[++lex->index];
+				token encoding = lex_token(lex, ++lex->index);
 				if (encoding.type != TOKEN_INTEGER){
-					snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected enumerator encoding, found '%s'\n", encoding.string);
+					snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected enumerator encoding, found '%.*s'\n", (int)encoding.len, encoding.string);
 					return outer;
 				}
-				token true_semi = lex->tokens[++lex->index];
+				token true_semi = lex_token(lex, ++lex->index);
 				if (true_semi.type == TOKEN_SEMI){
 					outer.encoding[outer.union_c-1] = atoi(encoding.string);
 					break;
 				}
 			default:
-				snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected '{', for union data or '=' for enum encoding, found '%s'\n", open.string);
+				snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected '{', for union data or '=' for enum encoding, found '%.*s'\n", (int)open.len, open.string);
 				return outer;
 			}
 		}
 		else{
-			tok = lex->tokens[++lex->index];
-			token semi = lex->tokens[++lex->index];
+			if (token_starts_type(tok.type) == 0){
+				snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected identifier for enumerated union member or type for struct member, found '%.*s'\n", (int)tok.len, tok.string);
+				return outer;
+			}
+			type_ast type = parse_type(lex, mem, err, TOKEN_IDENTIFIER, 0);
+			if (*err != 0){
+				return outer;
+			}
+			tok = lex_token(lex, ++lex->index);
+			token semi = lex_token(lex, ++lex->index);
 			if (tok.type != TOKEN_IDENTIFIER || semi.type != TOKEN_SEMI){
-				snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected 'identifier ;' for struct member name, found '%s' '%s'\n", tok.string, semi.string);
+				snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected 'identifier ;' for struct member name, found '%.*s' '%.*s'\n", (int)tok.len, tok.string, (int)semi.len, semi.string);
 				return outer;
 			}
 			binding_ast binding = {
 				.type=type,
 				.name=tok
 			};
+			outer.binding_v = node_vector(mem, binding_ast, outer.binding_v, outer.binding_c);
 			outer.binding_v[outer.binding_c] = binding;
 			outer.binding_c += 1;
 		}
 	}
-	snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : How did you get here in struct parse\n");
+	snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Reached end of file while parsing struct\n");
 	return outer;
 }
 
 void
 parse_type_params(lexer* const lex, pool* const mem, type_ast* const outer){
-	uint64_t save = parse_save(lex, mem);
-	token param = lex->tokens[lex->index];
-	lex->index += 1;
+	uint64_t index = lex->index;
+	token param = lex_token(lex, index);
 	uint8_t paren = 0;
 	if (param.type == TOKEN_PAREN_OPEN){
 		paren = 1;
-		param = lex->tokens[lex->index];
-		lex->index += 1;
+		param = lex_token(lex, ++index);
 	}
-	uint64_t inner_save = save;
-	token* params = pool_request(mem, sizeof(token));
+	uint64_t first = index;
 	uint8_t param_c = 0;
-	while (param.type == TOKEN_IDENTIFIER){
-		params[param_c] = param;
+	while (param.type == TOKEN_IDENTIFIER && param_c < MAX_PARAMS){
 		param_c += 1;
-		inner_save = parse_save(lex, mem);
-		pool_request(mem, sizeof(token));
-		param = lex->tokens[lex->index];
-		lex->index += 1;
+		param = lex_token(lex, ++index);
 	}
-	parse_load(lex, mem, inner_save);
-	lex->index += 1;
 	if (paren == 1){
 		if (param.type != TOKEN_PAREN_CLOSE){
-			parse_load(lex, mem, save);
 			return;
 		}
-		param = lex->tokens[lex->index];
-		lex->index += 1;
+		param = lex_token(lex, ++index);
 	}
 	if (param.type != TOKEN_DEPENDS){
-		parse_load(lex, mem, save);
 		return;
 	}
+	lex->index = index+1;
 	outer->param_c = param_c;
-	outer->param_v = params;
+	outer->param_v = param_c == 0 ? NULL : node_array(mem, token, param_c);
+	for (uint8_t i = 0;i<param_c;++i){
+		outer->param_v[i] = lex_token(lex, first+i);
+	}
 }
 
 type_ast
 parse_eager_type_params(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_token){
-	token name = lex->tokens[lex->index];
+	token name = lex_token(lex, lex->index);
 	type_ast outer = (type_ast){
 		.tag=USER_TYPE,
 		.data.user.user=name,
@@ -363,6 +1428,7 @@ parse_eager_type_params(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE
 		.data.user.param_c=0,
 		.mut=0,
 		.param_c=0,
+		.pos=lex_pos(lex, name),
 		.param_v=NULL
 	};
 	switch (name.type){
@@ -375,10 +1441,11 @@ parse_eager_type_params(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE
 		if (outer.tag != BUFFER_TYPE){
 			type_ast base = outer;
 			outer.tag = POINTER_TYPE;
-			outer.data.pointer = pool_request(mem, sizeof(type_ast));
+			outer.data.pointer = node_new(mem, type_ast);
 			*outer.data.pointer = base;
 			outer.mut = 0;
 		}
+		outer.pos = lex_pos(lex, name);
 		break;
 	case TOKEN_PAREN_OPEN:
 		lex->index += 1;
@@ -386,6 +1453,7 @@ parse_eager_type_params(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE
 		if (*err != 0){
 			return outer;
 		}
+		outer.pos = lex_pos(lex, name);
 		break;
 	case TOKEN_BRACE_OPEN:
 		structure_ast s = parse_struct(lex, mem, err);
@@ -393,7 +1461,7 @@ parse_eager_type_params(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE
 			return outer;
 		}
 		outer.tag = STRUCT_TYPE;
-		outer.data.structure = pool_request(mem, sizeof(structure_ast));
+		outer.data.structure = node_new(mem, structure_ast);
 		*outer.data.structure = s;
 		break;
 	case TOKEN_U8:
@@ -443,12 +1511,12 @@ parse_eager_type_params(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE
 		if (*err != 0){
 			return outer;
 		}
-		outer.data.pointer = pool_request(mem, sizeof(type_ast));
+		outer.data.pointer = node_new(mem, type_ast);
 		*outer.data.pointer = procedure_optional;
 		break;
 	default:
 		if (name.type!=TOKEN_IDENTIFIER){
-			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected type name, found non identifier '%s'\n", name.string);
+			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected type name, found non identifier '%.*s'\n", (int)name.len, name.string);
 			return (type_ast){.tag=NONE_TYPE};
 		}
 		break;
@@ -458,7 +1526,7 @@ parse_eager_type_params(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE
 
 type_ast
 parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_token, uint8_t consume){
-	token name = lex->tokens[lex->index];
+	token name = lex_token(lex, lex->index);
 	type_ast outer = (type_ast){
 		.tag=USER_TYPE,
 		.data.user.user=name,
@@ -466,6 +1534,7 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 		.data.user.param_c=0,
 		.mut=0,
 		.param_c=0,
+		.pos=lex_pos(lex, name),
 		.param_v=NULL
 	};
 	switch (name.type){
@@ -478,10 +1547,11 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 		if (outer.tag != BUFFER_TYPE){
 			type_ast base = outer;
 			outer.tag = POINTER_TYPE;
-			outer.data.pointer = pool_request(mem, sizeof(type_ast));
+			outer.data.pointer = node_new(mem, type_ast);
 			*outer.data.pointer = base;
 			outer.mut = 0;
 		}
+		outer.pos = lex_pos(lex, name);
 		break;
 	case TOKEN_PAREN_OPEN:
 		lex->index += 1;
@@ -489,6 +1559,7 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 		if (*err != 0){
 			return outer;
 		}
+		outer.pos = lex_pos(lex, name);
 		break;
 	case TOKEN_BRACE_OPEN:
 		structure_ast s = parse_struct(lex, mem, err);
@@ -496,7 +1567,7 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 			return outer;
 		}
 		outer.tag = STRUCT_TYPE;
-		outer.data.structure = pool_request(mem, sizeof(structure_ast));
+		outer.data.structure = node_new(mem, structure_ast);
 		*outer.data.structure = s;
 		break;
 	case TOKEN_U8:
@@ -546,25 +1617,21 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 		if (*err != 0){
 			return outer;
 		}
-		outer.data.pointer = pool_request(mem, sizeof(type_ast));
+		outer.data.pointer = node_new(mem, type_ast);
 		*outer.data.pointer = procedure_optional;
 		break;
 	default:
 		if (name.type!=TOKEN_IDENTIFIER){
-			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected type name, found non identifier '%s'\n", name.string);
+			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected type name, found non identifier '%.*s'\n", (int)name.len, name.string);
 			return (type_ast){.tag=NONE_TYPE};
 		}
-		uint64_t param_copy;
-		if (outer.data.user.param_v == NULL){
-			outer.data.user.param_v = pool_request(mem, MAX_PARAMS*sizeof(type_ast));
-		}
-		while (*err == 0){
-			param_copy = parse_save(lex, mem);
-			token iden_end = lex->tokens[++lex->index];
+		while (1){
+			token iden_end = lex_token(lex, lex->index+1);
 			if (iden_end.type == end_token || (end_token == TOKEN_IDENTIFIER && iden_end.type == TOKEN_SYMBOL)){
-				if (consume == 0){
-					parse_load(lex, mem, param_copy);
+				if (consume == 1){
+					lex->index += 1;
 				}
+				node_trim(mem, type_ast, outer.data.user.param_v, outer.data.user.param_c);
 				if (end_token == TOKEN_BRACK_CLOSE){
 					if (outer.data.user.param_c > 0){
 						outer.data.user.param_c -= 1;
@@ -573,7 +1640,7 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 							token identok = last->data.user.user;
 							type_ast idenbase = outer;
 							outer.tag = BUFFER_TYPE;
-							outer.data.buffer.base = pool_request(mem, sizeof(type_ast));
+							outer.data.buffer.base = node_new(mem, type_ast);
 							*outer.data.buffer.base = idenbase;
 							outer.data.buffer.count = 0;
 							outer.data.buffer.constant = 1;
@@ -586,23 +1653,26 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 				}
 				return outer;
 			}
+			if (token_starts_type(iden_end.type) == 0){
+				break;
+			}
+			lex->index += 1;
 			type_ast parameter = parse_eager_type_params(lex, mem, err, end_token);
 			if (*err != 0){
-				break;
+				return outer;
 			}
+			outer.data.user.param_v = node_vector(mem, type_ast, outer.data.user.param_v, outer.data.user.param_c);
 			outer.data.user.param_v[outer.data.user.param_c] = parameter;
 			outer.data.user.param_c += 1;
 		}
-		*err = 0;
-		parse_load(lex, mem, param_copy);
+		node_trim(mem, type_ast, outer.data.user.param_v, outer.data.user.param_c);
 		break;
 	}
-	while (lex->index < lex->token_count){
-		uint64_t copy = parse_save(lex, mem);
-		token tok = lex->tokens[++lex->index];
+	while (lex_more(lex)){
+		token tok = lex_token(lex, ++lex->index);
 		if (tok.type == end_token || (end_token == TOKEN_IDENTIFIER && tok.type == TOKEN_SYMBOL)){
 			if (consume == 0){
-				parse_load(lex, mem, copy);
+				lex->index -= 1;
 			}
 			return outer;
 		}
@@ -621,7 +1691,7 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 			}
 			type_ast idenbase = outer;
 			outer.tag = BUFFER_TYPE;
-			outer.data.buffer.base = pool_request(mem, sizeof(type_ast));
+			outer.data.buffer.base = node_new(mem, type_ast);
 			*outer.data.buffer.base = idenbase;
 			outer.data.buffer.count = 0;
 			outer.data.buffer.constant = 1;
@@ -637,7 +1707,7 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 			}
 			type_ast base = outer;
 			outer.tag = BUFFER_TYPE;
-			outer.data.buffer.base = pool_request(mem, sizeof(type_ast));
+			outer.data.buffer.base = node_new(mem, type_ast);
 			*outer.data.buffer.base = base;
 			outer.data.buffer.count = atoi(tok.string);
 			outer.data.buffer.constant = 0;
@@ -648,8 +1718,8 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 		case TOKEN_FUNC_IMPL:
 			type_ast arg = outer;
 			outer.tag = FUNCTION_TYPE;
-			outer.data.function.left = pool_request(mem, sizeof(type_ast));
-			outer.data.function.right = pool_request(mem, sizeof(type_ast));
+			outer.data.function.left = node_new(mem, type_ast);
+			outer.data.function.right = node_new(mem, type_ast);
 			*outer.data.function.left = arg;
 			outer.mut = 0;
 			outer.param_v = NULL;
@@ -658,7 +1728,7 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 			*outer.data.function.right = parse_type(lex, mem, err, end_token, consume);
 			return outer;
 		default:
-			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Unexpected token in or after type: '%s'\n", tok.string);
+			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Unexpected token in or after type: '%.*s'\n", (int)tok.len, tok.string);
 			return outer;
 		}
 	}
@@ -668,9 +1738,9 @@ parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_toke
 
 new_type_ast
 parse_new_type(lexer* const lex, pool* const mem, char* err){
-	token name = lex->tokens[++lex->index];
+	token name = lex_token(lex, ++lex->index);
 	if (name.type != TOKEN_IDENTIFIER){
-		snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected identifier for type new_type name, found '%s'\n", name.string);
+		snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected identifier for type new_type name, found '%.*s'\n", (int)name.len, name.string);
 		return (new_type_ast){};
 	}
 	lex->index += 1;
@@ -693,7 +1763,7 @@ parse_new_type(lexer* const lex, pool* const mem, char* err){
 
 constant_ast
 parse_constant(lexer* const lex, pool* const mem, char* err){
-	token name = lex->tokens[++lex->index];
+	token name = lex_token(lex, ++lex->index);
 	constant_ast constant = {
 		.value.type.tag=PRIMITIVE_TYPE,
 		.value.type.data.primitive=INT_ANY
@@ -703,11 +1773,11 @@ parse_constant(lexer* const lex, pool* const mem, char* err){
 		return constant;
 	}
 	constant.name=name;
-	token eq = lex->tokens[++lex->index];
+	token eq = lex_token(lex, ++lex->index);
 	if (eq.type != TOKEN_SET){
 		snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected token '=' to set constant value\n");
 	}
-	token val = lex->tokens[++lex->index];
+	token val = lex_token(lex, ++lex->index);
 	switch (val.type){
 	case TOKEN_FLOAT:
 		constant.value.type=(type_ast){
@@ -727,7 +1797,7 @@ parse_constant(lexer* const lex, pool* const mem, char* err){
 		snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Constants can currently only evaluate to integers and floats, in the future this may just be turned into a compile time expression evaluation feature\n");
 		return constant;
 	}
-	token semi = lex->tokens[++lex->index];
+	token semi = lex_token(lex, ++lex->index);
 	if (semi.type != TOKEN_SEMI){
 		snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Constants definitions must end with token ';'\n");
 		return constant;
@@ -750,16 +1820,16 @@ parse_function(lexer* const lex, pool* const mem, char* err, uint8_t allowed_enc
 			.type=type
 		};
 	}
-	token name = lex->tokens[++lex->index];
+	token name = lex_token(lex, ++lex->index);
 	if (name.type != TOKEN_IDENTIFIER && name.type != TOKEN_SYMBOL){
-		snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected function name, found '%s'\n", name.string);
+		snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected function name, found '%.*s'\n", (int)name.len, name.string);
 		return (function_ast){};
 	}
-	token tok = lex->tokens[++lex->index];
+	token tok = lex_token(lex, ++lex->index);
 	uint8_t enclosing = 0;
 	if (tok.type != TOKEN_SET){
 		if (allowed_enclosing != 1 || tok.type != TOKEN_ENCLOSE){
-			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected '=' to set function to value, found %s\n", tok.string);
+			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected '=' to set function to value, found %.*s\n", (int)tok.len, tok.string);
 			return (function_ast){};
 		}
 		enclosing = 1;
@@ -782,129 +1852,99 @@ parse_lambda(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_to
 	expression_ast outer = {
 		.tag=LAMBDA_EXPRESSION,
 		.data.lambda={
-			.argv=pool_request(mem, sizeof(token)*MAX_ARGS),
+			.argv=NULL,
 			.argc=0,
 			.expression=NULL,
 			.type.tag=NONE_TYPE
-		}
+		},
+		.pos=lex_pos(lex, lex_token(lex, lex->index))
 	};
-	for (token tok = lex->tokens[++lex->index];
-		 lex->index<lex->token_count;
-		 tok=lex->tokens[++lex->index]
+	for (token tok = lex_token(lex, ++lex->index);
+		 lex_more(lex);
+		 tok=lex_token(lex, ++lex->index)
 	){
-		expression_ast build;
-		uint64_t copy;
+		expression_ast build = {
+			.pos=lex_pos(lex, tok)
+		};
+		if (tok.type != TOKEN_IDENTIFIER){
+			node_trim(mem, token, outer.data.lambda.argv, outer.data.lambda.argc);
+		}
 		switch (tok.type){
 		case TOKEN_IDENTIFIER:
+			outer.data.lambda.argv = node_vector(mem, token, outer.data.lambda.argv, outer.data.lambda.argc);
 			outer.data.lambda.argv[outer.data.lambda.argc] = tok;
 			outer.data.lambda.argc += 1;
-			if (outer.data.lambda.argc >= MAX_ARGS){
-				snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Too many args for arena allocated buffer\n");
-				return outer;
-			}
 			break;
 		case TOKEN_BRACK_OPEN:
-			copy = parse_save(lex, mem);
-			literal_ast lit = parse_array_literal(lex, mem, err);
-			if (*err == 0){
+			if (predict_literal(lex) == 1){
+				literal_ast lit = parse_array_literal(lex, mem, err);
+				if (*err != 0){
+					return outer;
+				}
 				build.tag = LITERAL_EXPRESSION;
 				build.data.literal = lit;
-				outer.data.lambda.expression = pool_request(mem, sizeof(expression_ast));
+				outer.data.lambda.expression = node_new(mem, expression_ast);
 				*outer.data.lambda.expression = build;
 				return outer;
 			}
-			parse_load(lex, mem, copy);
-			*err = 0;
 			lex->index += 1;
-			build = parse_application_expression(lex, mem, err, TOKEN_BRACK_CLOSE, 1, -1);
+			build = parse_group_body(lex, mem, err, TOKEN_BRACK_CLOSE);
 			if (*err != 0){
 				return outer;
 			}
 			expression_ast deref = {
 				.tag=DEREF_EXPRESSION,
-				.data.deref = pool_request(mem, sizeof(expression_ast))
+				.data.deref = node_new(mem, expression_ast),
+				.pos=lex_pos(lex, tok)
 			};
 			*deref.data.deref = build;
-			outer.data.lambda.expression = pool_request(mem, sizeof(expression_ast));
+			outer.data.lambda.expression = node_new(mem, expression_ast);
 			*outer.data.lambda.expression = deref;
 			return outer;
 		case TOKEN_BRACE_OPEN:
-			copy = parse_save(lex, mem);
-			lit = parse_struct_literal(lex, mem, err);
-			if (*err == 0){
+			if (predict_literal(lex) == 1){
+				literal_ast lit = parse_struct_literal(lex, mem, err);
+				if (*err != 0){
+					return outer;
+				}
 				build.tag = LITERAL_EXPRESSION;
 				build.data.literal = lit;
-				outer.data.lambda.expression = pool_request(mem, sizeof(expression_ast));
+				outer.data.lambda.expression = node_new(mem, expression_ast);
 				*outer.data.lambda.expression = build;
 				return outer;
 			}
-			parse_load(lex, mem, copy);
-			*err = 0;
 			lex->index += 1;
-			build = parse_application_expression(lex, mem, err, TOKEN_BRACE_CLOSE, 1, -1);
+			build = parse_group_body(lex, mem, err, TOKEN_BRACE_CLOSE);
 			if (*err != 0){
 				return outer;
 			}
 			expression_ast access = {
 				.tag=ACCESS_EXPRESSION,
-				.data.deref = pool_request(mem, sizeof(expression_ast))
+				.data.deref = node_new(mem, expression_ast),
+				.pos=lex_pos(lex, tok)
 			};
 			*access.data.deref = build;
-			outer.data.lambda.expression = pool_request(mem, sizeof(expression_ast));
+			outer.data.lambda.expression = node_new(mem, expression_ast);
 			*outer.data.lambda.expression = access;
 			return outer;
 		case TOKEN_PAREN_OPEN:
 			lex->index += 1;
-			build = parse_application_expression(lex, mem, err, TOKEN_PAREN_CLOSE, 1, -1);
+			build = parse_group_body(lex, mem, err, TOKEN_PAREN_CLOSE);
 			if (*err != 0){
 				return outer;
 			}
-			outer.data.lambda.expression = pool_request(mem, sizeof(expression_ast));
+			outer.data.lambda.expression = node_new(mem, expression_ast);
 			*outer.data.lambda.expression = build;
 			return outer;
 		default:
-			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Unexpected token provided as function argument: '%s'\n", tok.string);
+			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Unexpected token provided as function argument: '%.*s'\n", (int)tok.len, tok.string);
 			return outer;
 		}
 	}
-	snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Reached unexpected case in lambda parsing\n");
+	snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Reached end of file while parsing lambda\n");
 	return outer;
 }
 
-function_ast
-try_function(lexer* const lex, pool* const mem, char* err){
-	token expr = lex->tokens[lex->index];
-	function_ast func;
-	switch(expr.type){
-	case TOKEN_PROC:
-	case TOKEN_IDENTIFIER:
-	case TOKEN_BRACE_OPEN:
-	case TOKEN_PAREN_OPEN:
-	case TOKEN_BRACK_OPEN:
-	case TOKEN_U8:
-	case TOKEN_U16:
-	case TOKEN_U32:
-	case TOKEN_U64:
-	case TOKEN_I8:
-	case TOKEN_I16:
-	case TOKEN_I32:
-	case TOKEN_I64:
-	case TOKEN_F32:
-	case TOKEN_F64:
-		uint64_t copy = parse_save(lex, mem);
-		func = parse_function(lex, mem, err, 1);
-		if (*err == 0){
-			return func;
-		}
-		parse_load(lex, mem, copy);
-		return func;
-	default:
-		break;
-	}
-	*err = 1;
-	return func;
-}
-
 expression_ast
 unwrap_single_application(expression_ast single){
 	while ((single.tag == APPLICATION_EXPRESSION||single.tag==PARTIAL_EXPRESSION) && single.data.block.expr_c == 1){
@@ -913,90 +1953,119 @@ unwrap_single_application(expression_ast single){
 	return single;
 }
 
+void
+expression_push(pool* const mem, expression_ast* const outer, expression_ast item){
+	outer->data.block.expr_v = node_vector(mem, expression_ast, outer->data.block.expr_v, outer->data.block.expr_c);
+	outer->data.block.expr_v[outer->data.block.expr_c] = item;
+	outer->data.block.expr_c += 1;
+}
+
 expression_ast
 parse_block_expression(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_token, expression_ast first){
 	expression_ast outer = {
 		.tag=BLOCK_EXPRESSION,
 		.data.block.type={.tag=NONE_TYPE},
-		.data.block.expr_c=0
+		.data.block.expr_v=NULL,
+		.data.block.expr_c=0,
+		.pos=first.pos
 	};
-	outer.data.block.expr_v = pool_request(mem, BLOCK_MAX*sizeof(expression_ast));
 	first = unwrap_single_application(first);
 	if (first.tag != NOP_EXPRESSION){
-		outer.data.block.expr_c = 1;
-		outer.data.block.expr_v[0] = first;
+		expression_push(mem, &outer, first);
 	}
 	if (first.tag == RETURN_EXPRESSION){
+		node_trim(mem, expression_ast, outer.data.block.expr_v, outer.data.block.expr_c);
 		return outer;
 	}
-	for (token tok = lex->tokens[++lex->index];
-		 lex->index < lex->token_count;
-		 tok = lex->tokens[++lex->index]
+	for (token tok = lex_token(lex, ++lex->index);
+		 lex_more(lex);
+		 tok = lex_token(lex, ++lex->index)
 	){
 		expression_ast build = {
 			.tag=APPLICATION_EXPRESSION
 		};
 		if (tok.type == end_token){
+			node_trim(mem, expression_ast, outer.data.block.expr_v, outer.data.block.expr_c);
 			return outer;
 		}
+		uint64_t line = lex->index;
 		build = parse_application_expression(lex, mem, err, TOKEN_SEMI, 2, -1);
 		if (*err != 0){
+			if (parse_recover(lex, err, line, end_token) == 1){
+				continue;
+			}
 			return outer;
 		}
 		build = unwrap_single_application(build);
-		outer.data.block.expr_v[outer.data.block.expr_c] = build;
-		outer.data.block.expr_c += 1;
+		expression_push(mem, &outer, build);
 	}
-	snprintf(err, ERROR_BUFFER, " <!> Parser Error : how did you get to this condition in the block expression parser\n");
+	snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Reached end of file while parsing block\n");
 	return outer;
 }
 
+// a group's first line is parsed before it is known to be a block, so an error in it is recovered here at the group's own level
+// the rest of the group is then parsed as a block, as it would have been had the line parsed
+expression_ast
+parse_group_body(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_token){
+	uint64_t line = lex->index;
+	expression_ast body = parse_application_expression(lex, mem, err, end_token, 1, -1);
+	if (*err == 0 || parse_recover(lex, err, line, end_token) == 0){
+		return body;
+	}
+	expression_ast skipped = {
+		.tag=NOP_EXPRESSION,
+		.pos=lex_pos(lex, lex_token(lex, line))
+	};
+	return parse_block_expression(lex, mem, err, end_token, skipped);
+}
+
 expression_ast
 parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_token, uint8_t allow_block, int8_t limit){
-	token expr = lex->tokens[lex->index];
+	token expr = lex_token(lex, lex->index);
 	expression_ast outer = {
 		.tag=APPLICATION_EXPRESSION,
 		.data.block.type={.tag=NONE_TYPE},
-		.data.block.expr_c=0
+		.data.block.expr_v=NULL,
+		.data.block.expr_c=0,
+		.pos=lex_pos(lex, expr)
 	};
-	outer.data.block.expr_v = pool_request(mem, MAX_ARGS*sizeof(expression_ast));
-	if (allow_block != 0){
-		function_ast func = try_function(lex, mem, err);
-		if (*err == 0){
-			outer.tag = CLOSURE_EXPRESSION;
-			outer.data.closure.capture_v = NULL;
-			outer.data.closure.capture_c = 0;
-			outer.data.closure.func = pool_request(mem, sizeof(function_ast));
-			*outer.data.closure.func = func;
-			if (allow_block == 2){
-				return outer;
-			}
-			return parse_block_expression(lex, mem, err, end_token, outer);
+	if (allow_block != 0 && predict_function(lex) == 1){
+		function_ast func = parse_function(lex, mem, err, 1);
+		if (*err != 0){
+			return outer;
+		}
+		outer.tag = CLOSURE_EXPRESSION;
+		outer.data.closure.capture_v = NULL;
+		outer.data.closure.capture_c = 0;
+		outer.data.closure.func = node_new(mem, function_ast);
+		*outer.data.closure.func = func;
+		if (allow_block == 2){
+			return outer;
 		}
-		*err = 0;
+		return parse_block_expression(lex, mem, err, end_token, outer);
 	}
 	expression_ast pass_expression;
 	expression_ast* last_pass;
 	uint8_t pass = 0;
-	uint64_t limit_copy;
 	if (limit != -1){
 		if (allow_block != 0){
 			snprintf(err, ERROR_BUFFER, " <!> Parsing Assertion error : blocks cannot be allowed when applications are limit requested\n");
 			return outer;
 		}
-		limit_copy = parse_save(lex, mem);
-		expr = lex->tokens[++lex->index];
+		expr = lex_token(lex, ++lex->index);
 	}
 	LABEL_REQUEST label_req = LABEL_FULFILLED;
 	LABEL_REQUEST jump_req = LABEL_FULFILLED;
-	for (;lex->index < lex->token_count;expr=lex->tokens[++lex->index]){
+	for (;lex_more(lex);expr=lex_token(lex, ++lex->index)){
 		expression_ast build = {
-			.tag=BINDING_EXPRESSION
+			.tag=BINDING_EXPRESSION,
+			.pos=lex_pos(lex, expr)
 		};
 		literal_ast lit;
+		// a limited application stops before the token that ended it
 		if (expr.type == end_token){
 			if (limit != -1){
-				parse_load(lex, mem, limit_copy);
+				lex->index -= 1;
 			}
 			if (outer.data.block.expr_c == 0 && end_token == TOKEN_SEMI){
 				lex->index += 1;
@@ -1005,21 +2074,18 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			if (pass == 0){
 				return outer;
 			}
-			last_pass->data.block.expr_v[last_pass->data.block.expr_c] = outer;
-			last_pass->data.block.expr_c += 1;
+			expression_push(mem, last_pass, outer);
 			return pass_expression;
 		}
 		if (limit == 0 || (limit != -1 && expr.type == TOKEN_SEMI)){
-			parse_load(lex, mem, limit_copy);
+			lex->index -= 1;
 			if (pass == 0){
 				return outer;
 			}
-			last_pass->data.block.expr_v[last_pass->data.block.expr_c] = outer;
-			last_pass->data.block.expr_c += 1;
+			expression_push(mem, last_pass, outer);
 			return pass_expression;
 		}
 		uint8_t simple = 0;
-		uint64_t copy;
 		switch (expr.type){
 		case TOKEN_RETURN:
 			if (outer.data.block.expr_c != 0){
@@ -1027,7 +2093,7 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 				return outer;
 			}
 			build.tag = RETURN_EXPRESSION;
-			build.data.deref = pool_request(mem, sizeof(expression_ast));
+			build.data.deref = node_new(mem, expression_ast);
 			lex->index += 1;
 			expression_ast retexpr = parse_application_expression(lex, mem, err, end_token, allow_block, -1);
 			if (*err != 0){
@@ -1036,66 +2102,56 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			if (allow_block == 1 && retexpr.tag == BLOCK_EXPRESSION && retexpr.data.block.expr_c == 1){
 				retexpr.tag = APPLICATION_EXPRESSION;
 				*build.data.deref = retexpr;
-				outer.data.block.expr_v[outer.data.block.expr_c] = build;
-				outer.data.block.expr_c += 1;
+				expression_push(mem, &outer, build);
 				if (pass == 0){
 					return parse_block_expression(lex, mem, err, end_token, outer);
 				}
-				last_pass->data.block.expr_v[last_pass->data.block.expr_c] = outer;
-				last_pass->data.block.expr_c += 1;
+				expression_push(mem, last_pass, outer);
 				return parse_block_expression(lex, mem, err, end_token, pass_expression);
 			}
 			*build.data.deref = retexpr;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			if (pass == 0){
 				return outer;
 			}
-			last_pass->data.block.expr_v[last_pass->data.block.expr_c] = outer;
-			last_pass->data.block.expr_c += 1;
+			expression_push(mem, last_pass, outer);
 			return pass_expression;
 		case TOKEN_REF:
 			build.tag = REF_EXPRESSION;
-			build.data.deref = pool_request(mem, sizeof(expression_ast));
+			build.data.deref = node_new(mem, expression_ast);
 			lex->index += 1;
 			*build.data.deref = parse_application_expression(lex, mem, err, end_token, allow_block, -1);
 			if (*err != 0){
 				return outer;
 			}
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			if (pass == 0){
 				return outer;
 			}
-			last_pass->data.block.expr_v[last_pass->data.block.expr_c] = outer;
-			last_pass->data.block.expr_c += 1;
+			expression_push(mem, last_pass, outer);
 			return pass_expression;
 		case TOKEN_SIZEOF:
 			build.tag = SIZEOF_EXPRESSION;
-			copy = parse_save(lex, mem);
 			lex->index += 1;
-			build.data.size_of.type = parse_type(lex, mem, err, end_token, 0);
-			if (*err == 0){
+			if (predict_type(lex, end_token) == 1){
+				build.data.size_of.type = parse_type(lex, mem, err, end_token, 0);
+				if (*err != 0){
+					return outer;
+				}
 				build.data.size_of.target = NULL;
-				outer.data.block.expr_v[outer.data.block.expr_c] = build;
-				outer.data.block.expr_c += 1;
+				expression_push(mem, &outer, build);
 				break;
 			}
-			parse_load(lex, mem, copy);
-			*err = 0;
-			build.data.size_of.target = pool_request(mem, sizeof(expression_ast));
-			lex->index += 1;
+			build.data.size_of.target = node_new(mem, expression_ast);
 			*build.data.size_of.target = parse_application_expression(lex, mem, err, end_token, allow_block, -1);
 			if (*err != 0){
 				return outer;
 			}
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			if (pass == 0){
 				return outer;
 			}
-			last_pass->data.block.expr_v[last_pass->data.block.expr_c] = outer;
-			last_pass->data.block.expr_c += 1;
+			expression_push(mem, last_pass, outer);
 			return pass_expression;
 		case TOKEN_SET:
 			if (outer.data.block.expr_c != 1){
@@ -1114,12 +2170,11 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			build.tag=BINDING_EXPRESSION;
 			build.data.binding.type.tag=NONE_TYPE;
 			build.data.binding.name=expr;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			pass = 1;
 			pass_expression = outer;
 			outer.data.block.type.tag=NONE_TYPE;
-			outer.data.block.expr_v = pool_request(mem, MAX_ARGS*sizeof(expression_ast));
+			outer.data.block.expr_v = NULL;
 			outer.data.block.expr_c = 0;
 			last_pass = &pass_expression;
 			break;
@@ -1128,14 +2183,12 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			if (*err != 0){
 				return outer;
 			}
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			if (simple == 1){
 				if (pass == 0){
 					return outer;
 				}
-				last_pass->data.block.expr_v[last_pass->data.block.expr_c] = outer;
-				last_pass->data.block.expr_c += 1;
+				expression_push(mem, last_pass, outer);
 				return pass_expression;
 			}
 			break;
@@ -1166,23 +2219,22 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			if (outer.data.block.expr_c == 0){
 				build.data.binding.type.tag = NONE_TYPE;
 				build.data.binding.name=expr;
-				outer.data.block.expr_v[0] = build;
-				outer.data.block.expr_c = 1;
+				expression_push(mem, &outer, build);
 				break;
 			}
 			expression_ast left_expr = outer;
-			outer.data.block.expr_v = pool_request(mem, MAX_ARGS*sizeof(expression_ast));
-			outer.data.block.expr_c = 2;
+			outer.data.block.expr_v = NULL;
+			outer.data.block.expr_c = 0;
 			build.data.binding.type.tag=NONE_TYPE;
 			build.data.binding.name=expr;
-			outer.data.block.expr_v[0] = build;
-			outer.data.block.expr_v[1] = left_expr;
+			expression_push(mem, &outer, build);
+			expression_push(mem, &outer, left_expr);
 			break;
 		case TOKEN_CAST:
 			if (outer.data.block.expr_c == 0){
 				snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Pointer cast requires left argument\n");
 			}
-			token open_br = lex->tokens[++lex->index];
+			token open_br = lex_token(lex, ++lex->index);
 			if (open_br.type != TOKEN_BRACK_OPEN){
 				snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Attempted to cast to non pointer type\n");
 				return outer;
@@ -1194,28 +2246,28 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			}
 			expression_ast ptr_cast = {
 				.tag=CAST_EXPRESSION,
-				.data.cast.target=pool_request(mem, sizeof(expression_ast)),
-				.data.cast.type=cast_target
+				.data.cast.target=node_new(mem, expression_ast),
+				.data.cast.type=cast_target,
+				.pos=lex_pos(lex, expr)
 			};
 			*ptr_cast.data.cast.target = outer;
-			outer.data.block.expr_v = pool_request(mem, MAX_ARGS*sizeof(expression_ast));
-			outer.data.block.expr_c = 1;
-			outer.data.block.expr_v[0] = ptr_cast;
+			outer.data.block.expr_v = NULL;
+			outer.data.block.expr_c = 0;
+			expression_push(mem, &outer, ptr_cast);
 			break;
 		case TOKEN_PASS:
 			if (pass == 0){
 				pass = 1;
 				pass_expression = outer;
 				outer.data.block.type.tag=NONE_TYPE;
-				outer.data.block.expr_v = pool_request(mem, MAX_ARGS*sizeof(expression_ast));
+				outer.data.block.expr_v = NULL;
 				outer.data.block.expr_c = 0;
 				last_pass = &pass_expression;
 			}
 			else{
-				last_pass->data.block.expr_v[last_pass->data.block.expr_c] = outer;
-				last_pass->data.block.expr_c += 1;
+				expression_push(mem, last_pass, outer);
 				outer.data.block.type.tag=NONE_TYPE;
-				outer.data.block.expr_v = pool_request(mem, MAX_ARGS*sizeof(expression_ast));
+				outer.data.block.expr_v = NULL;
 				outer.data.block.expr_c = 0;
 				last_pass = &last_pass->data.block.expr_v[last_pass->data.block.expr_c-1];
 			}
@@ -1227,8 +2279,7 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 				.data.primitive=FLOAT_ANY
 			};
 			build.data.binding.name=expr;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			break;
 		case TOKEN_INTEGER:
 			build.tag = VALUE_EXPRESSION;
@@ -1237,75 +2288,70 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 				.data.primitive=INT_ANY
 			};
 			build.data.binding.name=expr;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			break;
 		case TOKEN_LABEL:
 			label_req = LABEL_REQUESTED;
 		case TOKEN_IDENTIFIER:
 			build.data.binding.type.tag=NONE_TYPE;
 			build.data.binding.name=expr;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			break;
 		case TOKEN_BRACK_OPEN:
-			copy = parse_save(lex, mem);
-			lit = parse_array_literal(lex, mem, err);
-			if (*err == 0){
+			if (predict_literal(lex) == 1){
+				lit = parse_array_literal(lex, mem, err);
+				if (*err != 0){
+					return outer;
+				}
 				build.tag = LITERAL_EXPRESSION;
 				build.data.literal = lit;
-				outer.data.block.expr_v[outer.data.block.expr_c] = build;
-				outer.data.block.expr_c += 1;
+				expression_push(mem, &outer, build);
 				break;
 			}
-			parse_load(lex, mem, copy);
-			*err = 0;
 			lex->index += 1;
-			build = parse_application_expression(lex, mem, err, TOKEN_BRACK_CLOSE, 1, -1);
+			build = parse_group_body(lex, mem, err, TOKEN_BRACK_CLOSE);
 			if (*err != 0){
 				return outer;
 			}
 			expression_ast deref = {
 				.tag=DEREF_EXPRESSION,
-				.data.deref = pool_request(mem, sizeof(expression_ast))
+				.data.deref = node_new(mem, expression_ast),
+				.pos=lex_pos(lex, expr)
 			};
 			*deref.data.deref = build;
-			outer.data.block.expr_v[outer.data.block.expr_c] = deref;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, deref);
 			break;
 		case TOKEN_PAREN_OPEN:
 			lex->index += 1;
-			build = parse_application_expression(lex, mem, err, TOKEN_PAREN_CLOSE, 1, -1);
+			build = parse_group_body(lex, mem, err, TOKEN_PAREN_CLOSE);
 			if (*err != 0){
 				return outer;
 			}
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			break;
 		case TOKEN_BRACE_OPEN:
-			copy = parse_save(lex, mem);
-			lit = parse_struct_literal(lex, mem, err);
-			if (*err == 0){
+			if (predict_literal(lex) == 1){
+				lit = parse_struct_literal(lex, mem, err);
+				if (*err != 0){
+					return outer;
+				}
 				build.tag = LITERAL_EXPRESSION;
 				build.data.literal = lit;
-				outer.data.block.expr_v[outer.data.block.expr_c] = build;
-				outer.data.block.expr_c += 1;
+				expression_push(mem, &outer, build);
 				break;
 			}
-			parse_load(lex, mem, copy);
-			*err = 0;
 			lex->index += 1;
-			build = parse_application_expression(lex, mem, err, TOKEN_BRACE_CLOSE, 1, -1);
+			build = parse_group_body(lex, mem, err, TOKEN_BRACE_CLOSE);
 			if (*err != 0){
 				return outer;
 			}
 			expression_ast access = {
 				.tag=ACCESS_EXPRESSION,
-				.data.deref = pool_request(mem, sizeof(expression_ast))
+				.data.deref = node_new(mem, expression_ast),
+				.pos=lex_pos(lex, expr)
 			};
 			*access.data.deref = build;
-			outer.data.block.expr_v[outer.data.block.expr_c] = access;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, access);
 			break;
 		case TOKEN_CHAR:
 			binding_ast char_lit = parse_char_literal(lex, mem, err);
@@ -1314,8 +2360,7 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			}
 			build.tag = VALUE_EXPRESSION;
 			build.data.binding = char_lit;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			break;
 		case TOKEN_STRING:
 			lit = parse_string_literal(lex, mem, err);
@@ -1324,8 +2369,7 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			}
 			build.tag = LITERAL_EXPRESSION;
 			build.data.literal = lit;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			break;
 		case TOKEN_IF:
 			build = parse_application_expression(lex, mem, err, end_token, 0, 3);
@@ -1338,8 +2382,8 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			}
 			statement_ast iff = {
 				.tag=IF_STATEMENT,
-				.data.if_statement.predicate = pool_request(mem, sizeof(expression_ast)),
-				.data.if_statement.branch = pool_request(mem, sizeof(expression_ast)),
+				.data.if_statement.predicate = node_new(mem, expression_ast),
+				.data.if_statement.branch = node_new(mem, expression_ast),
 				.data.if_statement.alternate = NULL,
 				.type.tag=NONE_TYPE,
 				.labeled=0
@@ -1347,7 +2391,7 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			*iff.data.if_statement.predicate = build.data.block.expr_v[0];
 			*iff.data.if_statement.branch = build.data.block.expr_v[1];
 			if (build.data.block.expr_c == 3){
-				iff.data.if_statement.alternate = pool_request(mem, sizeof(expression_ast));
+				iff.data.if_statement.alternate = node_new(mem, expression_ast);
 				*iff.data.if_statement.alternate = build.data.block.expr_v[2];
 			}
 			if (label_req == LABEL_WAITING){
@@ -1362,8 +2406,7 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			}
 			build.tag = STATEMENT_EXPRESSION;
 			build.data.statement = iff;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			break;
 		case TOKEN_FOR:
 			build = parse_application_expression(lex, mem, err, end_token, 0, 4);
@@ -1376,10 +2419,10 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			}
 			statement_ast forr = {
 				.tag=FOR_STATEMENT,
-				.data.for_statement.start = pool_request(mem, sizeof(expression_ast)),
-				.data.for_statement.end = pool_request(mem, sizeof(expression_ast)),
-				.data.for_statement.inc = pool_request(mem, sizeof(expression_ast)),
-				.data.for_statement.procedure = pool_request(mem, sizeof(expression_ast)),
+				.data.for_statement.start = node_new(mem, expression_ast),
+				.data.for_statement.end = node_new(mem, expression_ast),
+				.data.for_statement.inc = node_new(mem, expression_ast),
+				.data.for_statement.procedure = node_new(mem, expression_ast),
 				.type.tag=NONE_TYPE,
 				.labeled=0
 			};
@@ -1399,8 +2442,7 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			}
 			build.tag = STATEMENT_EXPRESSION;
 			build.data.statement = forr;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			break;
 		case TOKEN_BREAK:
 			if (outer.data.block.expr_c != 0){
@@ -1415,8 +2457,7 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			jump_req = LABEL_REQUESTED;
 			build.tag = STATEMENT_EXPRESSION;
 			build.data.statement = brk;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			break;
 		case TOKEN_CONTINUE:
 			if (outer.data.block.expr_c != 0){
@@ -1431,8 +2472,7 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 			jump_req = LABEL_REQUESTED;
 			build.tag = STATEMENT_EXPRESSION;
 			build.data.statement = cnt;
-			outer.data.block.expr_v[outer.data.block.expr_c] = build;
-			outer.data.block.expr_c += 1;
+			expression_push(mem, &outer, build);
 			break;
 		case TOKEN_LABEL_JUMP:
 			if (jump_req != LABEL_WAITING){
@@ -1461,102 +2501,399 @@ parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN
 				if (pass == 0){
 					return parse_block_expression(lex, mem, err, end_token, outer);
 				}
-				last_pass->data.block.expr_v[last_pass->data.block.expr_c] = outer;
-				last_pass->data.block.expr_c += 1;
+				expression_push(mem, last_pass, outer);
 				return parse_block_expression(lex, mem, err, end_token, pass_expression);
 			}
 		case TOKEN_BRACK_CLOSE:
 		case TOKEN_PAREN_CLOSE:
 		default:
-			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Unexpected token '%s'\n", expr.string);
+			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Unexpected token '%.*s'\n", (int)expr.len, expr.string);
+			return outer;
+		}
+		if (limit > 0){
+			limit -= 1;
+		}
+		if (label_req == LABEL_WAITING){
+			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : label must precede statement\n");
+			return outer;
+		}
+		if (jump_req == LABEL_WAITING){
+			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : jump label must succeed jump directive statement\n");
+			return outer;
+		}
+		if (jump_req == LABEL_EXPIRED){
+			jump_req = LABEL_OVERDUE;
+		}
+		else if (jump_req == LABEL_OVERDUE){
+			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected end of jump directive statement\n");
 			return outer;
 		}
-		if (limit != -1){
-			limit_copy = parse_save(lex, mem);
-			if (limit > 0){
-				limit -= 1;
+		if (label_req == LABEL_REQUESTED){
+			label_req = LABEL_WAITING;
+		}
+		if (jump_req == LABEL_REQUESTED){
+			jump_req = LABEL_WAITING;
+		}
+	}
+	snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Reached end of file while parsing expression\n");
+	return outer;
+}
+
+literal_ast
+parse_struct_literal(lexer* const lex, pool* const mem, char* err){
+	literal_ast lit = {
+		.tag=STRUCT_LITERAL,
+		.type.tag=NONE_TYPE
+	};
+	lit.data.array.member_v = NULL;
+	lit.data.array.member_c = 0;
+	token tok = lex_token(lex, ++lex->index);
+	if (tok.type == TOKEN_BRACE_CLOSE){
+		return lit;
+	}
+	expression_ast build = parse_application_expression(lex, mem, err, TOKEN_COMMA, 0, -1);
+	if (*err != 0){
+		return lit;
+	}
+	literal_push(mem, &lit, build);
+	tok = lex_token(lex, ++lex->index);
+	if (tok.type == TOKEN_BRACE_CLOSE){
+		node_trim(mem, expression_ast, lit.data.array.member_v, lit.data.array.member_c);
+		return lit;
+	}
+	while (1){
+		TOKEN_TYPE_TAG end = predict_member_end(lex, TOKEN_BRACE_CLOSE);
+		build = parse_application_expression(lex, mem, err, end, 0, -1);
+		if (*err != 0){
+			return lit;
+		}
+		literal_push(mem, &lit, build);
+		if (end == TOKEN_BRACE_CLOSE){
+			node_trim(mem, expression_ast, lit.data.array.member_v, lit.data.array.member_c);
+			return lit;
+		}
+		tok = lex_token(lex, ++lex->index);
+	}
+}
+
+void
+literal_push(pool* const mem, literal_ast* const lit, expression_ast item){
+	lit->data.array.member_v = node_vector(mem, expression_ast, lit->data.array.member_v, lit->data.array.member_c);
+	lit->data.array.member_v[lit->data.array.member_c] = item;
+	lit->data.array.member_c += 1;
+}
+
+uint8_t
+token_opens(TOKEN_TYPE_TAG type){
+	return type == TOKEN_BRACK_OPEN || type == TOKEN_PAREN_OPEN || type == TOKEN_BRACE_OPEN;
+}
+
+uint8_t
+token_closes(TOKEN_TYPE_TAG type){
+	return type == TOKEN_BRACK_CLOSE || type == TOKEN_PAREN_CLOSE || type == TOKEN_BRACE_CLOSE;
+}
+
+TOKEN_TYPE_TAG
+token_closer(TOKEN_TYPE_TAG open){
+	switch (open){
+	case TOKEN_BRACK_OPEN:
+		return TOKEN_BRACK_CLOSE;
+	case TOKEN_PAREN_OPEN:
+		return TOKEN_PAREN_CLOSE;
+	case TOKEN_BRACE_OPEN:
+		return TOKEN_BRACE_CLOSE;
+	default:
+		return TOKEN_EOF;
+	}
+}
+
+// first set of parse_type and of a user type parameter
+uint8_t
+token_starts_type(TOKEN_TYPE_TAG type){
+	switch (type){
+	case TOKEN_PROC:
+	case TOKEN_IDENTIFIER:
+	case TOKEN_BRACE_OPEN:
+	case TOKEN_PAREN_OPEN:
+	case TOKEN_BRACK_OPEN:
+	case TOKEN_U8:
+	case TOKEN_U16:
+	case TOKEN_U32:
+	case TOKEN_U64:
+	case TOKEN_I8:
+	case TOKEN_I16:
+	case TOKEN_I32:
+	case TOKEN_I64:
+	case TOKEN_F32:
+	case TOKEN_F64:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// tokens a type is made of outside of its brackets
+uint8_t
+token_in_type(TOKEN_TYPE_TAG type){
+	if (type == TOKEN_MUTABLE || type == TOKEN_FUNC_IMPL){
+		return 1;
+	}
+	return token_starts_type(type) && token_opens(type) == 0;
+}
+
+// the predictive parser looks ahead from lex->index without moving it or allocating, so every construct is parsed once
+
+// index of the token closing the group opened at open, or of the end of input when it is never closed
+// each group is scanned once, later lookahead over it reads the memo, so nested predictions stay linear
+uint64_t
+lex_group_end(lexer* const lex, uint64_t open){
+	if (lex_fill(lex, open) == 1 && lex->group_end[open & (lex->capacity-1)] != 0){
+		return lex->group_end[open & (lex->capacity-1)]-1;
+	}
+	uint64_t index = open+1;
+	for (token tok = lex_token(lex, index);tok.type != TOKEN_EOF;tok = lex_token(lex, ++index)){
+		if (token_opens(tok.type)){
+			index = lex_group_end(lex, index);
+		}
+		else if (token_closes(tok.type)){
+			break;
+		}
+	}
+	// the scan may have grown the ring, so the slot is found again
+	if (lex_fill(lex, open) == 1){
+		lex->group_end[open & (lex->capacity-1)] = index+1;
+	}
+	return index;
+}
+
+// a block line declares a function when a type is followed by a name and '=' before any token only an expression contains
+uint8_t
+predict_function(lexer* const lex){
+	uint64_t index = lex->index;
+	token tok = lex_token(lex, index);
+	if (token_starts_type(tok.type) == 0){
+		return 0;
+	}
+	for (;tok.type != TOKEN_EOF;tok = lex_token(lex, ++index)){
+		if (token_opens(tok.type)){
+			index = lex_group_end(lex, index);
+			continue;
+		}
+		if ((tok.type == TOKEN_IDENTIFIER || tok.type == TOKEN_SYMBOL) && index != lex->index){
+			TOKEN_TYPE_TAG next = lex_token(lex, index+1).type;
+			if (next == TOKEN_SET || next == TOKEN_ENCLOSE){
+				return 1;
+			}
+		}
+		if (token_in_type(tok.type) == 0 && tok.type != TOKEN_DEPENDS){
+			return 0;
+		}
+	}
+	return 0;
+}
+
+// whether the tokens up to end_token read as a type, for forms that take either a type or an expression
+uint8_t
+predict_type(lexer* const lex, TOKEN_TYPE_TAG end_token){
+	uint64_t index = lex->index;
+	for (token tok = lex_token(lex, index);tok.type != TOKEN_EOF;tok = lex_token(lex, ++index)){
+		if (tok.type == end_token){
+			return index != lex->index;
+		}
+		if (token_opens(tok.type)){
+			if (predict_type_group(lex, index, 0) == 0){
+				return 0;
+			}
+			index = lex_group_end(lex, index);
+			continue;
+		}
+		if (token_in_type(tok.type) == 0){
+			return 0;
+		}
+	}
+	return 0;
+}
+
+// a bracket may end in a buffer size, a brace is a struct only once a member ends in ';', a parenthesis holds a plain type
+// braces nested in a struct may be empty, they are union members without data
+uint8_t
+predict_type_group(lexer* const lex, uint64_t open, uint8_t in_struct){
+	TOKEN_TYPE_TAG kind = lex_token(lex, open).type;
+	uint64_t end = lex_group_end(lex, open);
+	if (lex_token(lex, end).type != token_closer(kind)){
+		return 0;
+	}
+	uint8_t member = 0;
+	TOKEN_TYPE_TAG prev = kind;
+	for (uint64_t index = open+1;index<end;++index){
+		token tok = lex_token(lex, index);
+		if (token_opens(tok.type)){
+			if (predict_type_group(lex, index, kind == TOKEN_BRACE_OPEN) == 0){
+				return 0;
 			}
+			index = lex_group_end(lex, index);
+			prev = TOKEN_BRACE_CLOSE;
+			continue;
 		}
-		if (label_req == LABEL_WAITING){
-			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : label must precede statement\n");
-			return outer;
-		}
-		if (jump_req == LABEL_WAITING){
-			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : jump label must succeed jump directive statement\n");
-			return outer;
+		if (token_in_type(tok.type) == 1
+		 || (kind == TOKEN_BRACK_OPEN && tok.type == TOKEN_INTEGER)
+		 || (kind == TOKEN_BRACE_OPEN && tok.type == TOKEN_SET)
+		 || (kind == TOKEN_BRACE_OPEN && tok.type == TOKEN_INTEGER && prev == TOKEN_SET)){
+			prev = tok.type;
+			continue;
 		}
-		if (jump_req == LABEL_EXPIRED){
-			jump_req = LABEL_OVERDUE;
+		if (kind == TOKEN_BRACE_OPEN && tok.type == TOKEN_SEMI){
+			member = 1;
+			prev = tok.type;
+			continue;
 		}
-		else if (jump_req == LABEL_OVERDUE){
-			snprintf(err, ERROR_BUFFER, " <!> Parsing Error at : Expected end of jump directive statement\n");
-			return outer;
+		return 0;
+	}
+	return kind != TOKEN_BRACE_OPEN || member == 1 || (in_struct == 1 && end == open+1);
+}
+
+// a bracketed or braced group at lex->index is a literal when it is empty or separates members with ','
+uint8_t
+predict_literal(lexer* const lex){
+	uint64_t index = lex->index+1;
+	for (token tok = lex_token(lex, index);tok.type != TOKEN_EOF;tok = lex_token(lex, ++index)){
+		if (token_opens(tok.type)){
+			index = lex_group_end(lex, index);
+			continue;
 		}
-		if (label_req == LABEL_REQUESTED){
-			label_req = LABEL_WAITING;
+		if (token_closes(tok.type)){
+			return index == lex->index+1;
 		}
-		if (jump_req == LABEL_REQUESTED){
-			jump_req = LABEL_WAITING;
+		if (tok.type == TOKEN_COMMA){
+			return 1;
 		}
 	}
-	snprintf(err, ERROR_BUFFER, " <!> Parser Error at : How did you get here in the application parser\n");
-	return outer;
+	return 0;
 }
 
-literal_ast
-parse_struct_literal(lexer* const lex, pool* const mem, char* err){
-	literal_ast lit = {
-		.tag=STRUCT_LITERAL,
-		.type.tag=NONE_TYPE
-	};
-	lit.data.array.member_v = NULL;
-	lit.data.array.member_c = 0;
-	token tok = lex->tokens[++lex->index];
-	if (tok.type == TOKEN_BRACE_CLOSE){
-		return lit;
-	}
-	lit.data.array.member_v = pool_request(mem, MAX_ARGS*sizeof(expression_ast));
-	expression_ast build = parse_application_expression(lex, mem, err, TOKEN_COMMA, 0, -1);
-	if (*err != 0){
-		return lit;
-	}
-	lit.data.array.member_v[lit.data.array.member_c] = build;
-	lit.data.array.member_c += 1;
-	tok = lex->tokens[++lex->index];
-	if (tok.type == TOKEN_BRACE_CLOSE){
-		return lit;
-	}
-	while (1){
-		uint64_t copy = parse_save(lex, mem);
-		expression_ast build = parse_application_expression(lex, mem, err, TOKEN_COMMA, 0, -1);
-		if (*err == 0){
-			lit.data.array.member_v[lit.data.array.member_c] = build;
-			lit.data.array.member_c += 1;
-			tok = lex->tokens[++lex->index];
+// a literal member runs to the next ',' unless it is the last one
+TOKEN_TYPE_TAG
+predict_member_end(lexer* const lex, TOKEN_TYPE_TAG close){
+	uint64_t index = lex->index;
+	for (token tok = lex_token(lex, index);tok.type != TOKEN_EOF;tok = lex_token(lex, ++index)){
+		if (token_opens(tok.type)){
+			index = lex_group_end(lex, index);
 			continue;
 		}
-		parse_load(lex, mem, copy);
-		*err = 0;
-		build = parse_application_expression(lex, mem, err, TOKEN_BRACE_CLOSE, 0, -1);
-		if (*err != 0){
-			return lit;
+		if (tok.type == TOKEN_COMMA){
+			return TOKEN_COMMA;
+		}
+		if (token_closes(tok.type)){
+			return close;
 		}
-		lit.data.array.member_v[lit.data.array.member_c] = build;
-		lit.data.array.member_c += 1;
-		return lit;
 	}
+	return close;
 }
 
-uint64_t
-parse_save(lexer* const lex, pool* const mem){
-	pool_save(mem);
-	return lex->index;
+// an identifier followed by ';', '=' or a braced body starts an enumerated union member rather than a typed binding
+uint8_t
+predict_union_member(lexer* const lex){
+	uint64_t index = lex->index;
+	if (lex_token(lex, index).type != TOKEN_IDENTIFIER){
+		return 0;
+	}
+	TOKEN_TYPE_TAG next = lex_token(lex, index+1).type;
+	if (next == TOKEN_BRACE_OPEN){
+		next = lex_token(lex, lex_group_end(lex, index+1)+1).type;
+	}
+	return next == TOKEN_SEMI || next == TOKEN_SET;
 }
 
+// an enclosing construct failing on the token an inner one already reported adds nothing, so only the first is kept
 void
-parse_load(lexer* const lex, pool* const mem, uint64_t index){
-	pool_load(mem);
-	lex->index = index;
+diagnostic_push(lexer* const lex, const char* const message){
+	diagnostics* const diag = lex->diag;
+	source_pos pos = lex_pos(lex, lex_token(lex, lex->index));
+	if (diag->diag_c != 0 && diag->diag_v[diag->diag_c-1].pos.offset == pos.offset){
+		return;
+	}
+	if (diag->diag_c == diag->diag_capacity){
+		diag->diag_capacity = diag->diag_capacity == 0 ? DIAGNOSTIC_CHUNK : diag->diag_capacity*2;
+		diag->diag_v = pool_require(realloc(diag->diag_v, sizeof(diagnostic)*diag->diag_capacity));
+	}
+	diagnostic* const d = &diag->diag_v[diag->diag_c];
+	diag->diag_c += 1;
+	d->pos = pos;
+	snprintf(d->message, ERROR_BUFFER, "%s", message);
+}
+
+// in recovering mode the pending error is recorded and parsing resumes after the ';' ending the line that began at start
+// the line is scanned from start to know which groups are open, but it only ends at or past the token the error was raised on
+// a closer pops back to the innermost opener of its kind, openers above it are taken as never closed
+// a closer no opener on the line matches is skipped when a group on the line is open, and that group is taken as mistyped
+// a ';' directly inside '[' or inside a mistyped group cannot belong to it, so that group is taken as never closed
+// with no group open, a stray closer is skipped at the top level, ends the line when it is the block's own closer,
+// and otherwise is left to the enclosing line, whose group it most likely closes
+// returns 0 with err still set when not recovering, or when the input ends inside a block
+uint8_t
+parse_recover(lexer* const lex, char* const err, uint64_t start, TOKEN_TYPE_TAG close){
+	if (lex->diag == NULL){
+		return 0;
+	}
+	TOKEN_TYPE_TAG open_v[RECOVER_DEPTH];
+	uint8_t mistyped_v[RECOVER_DEPTH];
+	uint32_t open_c = 0;
+	uint64_t failed = lex->index;
+	uint64_t index = start;
+	for (token tok = lex_token(lex, index);tok.type != TOKEN_EOF;tok = lex_token(lex, ++index)){
+		if (token_opens(tok.type)){
+			if (open_c == RECOVER_DEPTH){
+				return 0;
+			}
+			open_v[open_c] = tok.type;
+			mistyped_v[open_c] = 0;
+			open_c += 1;
+			continue;
+		}
+		if (token_closes(tok.type)){
+			uint32_t depth = open_c;
+			while (depth != 0 && token_closer(open_v[depth-1]) != tok.type){
+				depth -= 1;
+			}
+			if (depth != 0){
+				open_c = depth-1;
+				continue;
+			}
+			if (tok.type != close && open_c != 0){
+				mistyped_v[open_c-1] = 1;
+				continue;
+			}
+			if (index < failed || close == TOKEN_EOF){
+				continue;
+			}
+			if (tok.type != close){
+				return 0;
+			}
+			diagnostic_push(lex, err);
+			*err = 0;
+			lex->index = index-1;
+			return 1;
+		}
+		if (tok.type != TOKEN_SEMI){
+			continue;
+		}
+		if (open_c != 0 && (open_v[open_c-1] == TOKEN_BRACK_OPEN || mistyped_v[open_c-1] == 1)){
+			open_c -= 1;
+		}
+		if (open_c == 0 && index >= failed){
+			diagnostic_push(lex, err);
+			*err = 0;
+			lex->index = index;
+			return 1;
+		}
+	}
+	if (close != TOKEN_EOF){
+		return 0;
+	}
+	diagnostic_push(lex, err);
+	*err = 0;
+	lex->index = index-1;
+	return 1;
 }
 
 literal_ast
@@ -1567,39 +2904,32 @@ parse_array_literal(lexer* const lex, pool* const mem, char* err){
 	};
 	lit.data.array.member_v = NULL;
 	lit.data.array.member_c = 0;
-	token tok = lex->tokens[++lex->index];
+	token tok = lex_token(lex, ++lex->index);
 	if (tok.type == TOKEN_BRACK_CLOSE){
 		return lit;
 	}
-	lit.data.array.member_v = pool_request(mem, MAX_ARGS*sizeof(expression_ast));
 	expression_ast build = parse_application_expression(lex, mem, err, TOKEN_COMMA, 0, -1);
 	if (*err != 0){
 		return lit;
 	}
-	lit.data.array.member_v[lit.data.array.member_c] = build;
-	lit.data.array.member_c += 1;
-	tok = lex->tokens[++lex->index];
+	literal_push(mem, &lit, build);
+	tok = lex_token(lex, ++lex->index);
 	if (tok.type == TOKEN_BRACK_CLOSE){
+		node_trim(mem, expression_ast, lit.data.array.member_v, lit.data.array.member_c);
 		return lit;
 	}
 	while (1){
-		uint64_t copy = parse_save(lex, mem);
-		build = parse_application_expression(lex, mem, err, TOKEN_COMMA, 0, -1);
-		if (*err == 0){
-			lit.data.array.member_v[lit.data.array.member_c] = build;
-			lit.data.array.member_c += 1;
-			tok = lex->tokens[++lex->index];
-			continue;
-		}
-		parse_load(lex, mem, copy);
-		*err = 0;
-		build = parse_application_expression(lex, mem, err, TOKEN_BRACK_CLOSE, 0, -1);
+		TOKEN_TYPE_TAG end = predict_member_end(lex, TOKEN_BRACK_CLOSE);
+		build = parse_application_expression(lex, mem, err, end, 0, -1);
 		if (*err != 0){
 			return lit;
 		}
-		lit.data.array.member_v[lit.data.array.member_c] = build;
-		lit.data.array.member_c += 1;
-		return lit;
+		literal_push(mem, &lit, build);
+		if (end == TOKEN_BRACK_CLOSE){
+			node_trim(mem, expression_ast, lit.data.array.member_v, lit.data.array.member_c);
+			return lit;
+		}
+		tok = lex_token(lex, ++lex->index);
 	}
 	snprintf(err, ERROR_BUFFER, " <!> Parser Error at : How did you get here in array literal parser\n");
 	return lit;
@@ -1607,11 +2937,15 @@ parse_array_literal(lexer* const lex, pool* const mem, char* err){
 
 binding_ast
 parse_char_literal(lexer* const lex, pool* const mem, char* err){
-	token tok = lex->tokens[lex->index];
+	token tok = lex_token(lex, lex->index);
 	binding_ast char_lit = {.type.tag=NONE_TYPE};
-	char target = tok.string[0];
-	snprintf(tok.string, 5, "%d", (int8_t)target);
-	tok.len = 3;
+	char target = tok.string[1];
+	if (target == '\\'){
+		target = *lex_escape(tok.string[2]);
+	}
+	char digits[5];
+	tok.len = snprintf(digits, 5, "%d", (int8_t)target);
+	tok.sym = intern_copy(lex->names, digits, tok.len, &tok.string);
 	tok.type = TOKEN_INTEGER;
 	char_lit.type.tag=PRIMITIVE_TYPE;
 	char_lit.type.data.primitive=I8_TYPE;
@@ -1625,14 +2959,37 @@ parse_string_literal(lexer* const lex, pool* const mem, char* err){
 		.tag=STRING_LITERAL,
 		.type.tag=NONE_TYPE
 	};
-	token current = lex->tokens[lex->index];
-	lit.data.string.content = current.string;
-	lit.data.string.length = current.len;
+	token current = lex_token(lex, lex->index);
+	const char* const quoted = current.string+1;
+	uint32_t quoted_len = current.len-2;
+	// a literal without escapes is its source text, otherwise it is decoded into the compile pool
+	if (memchr(quoted, '\\', quoted_len) == NULL){
+		lit.data.string.content = quoted;
+		lit.data.string.length = quoted_len;
+		return lit;
+	}
+	char* const content = pool_require(pool_request(mem, quoted_len));
+	uint32_t length = 0;
+	for (uint32_t k = 0;k<quoted_len;++k){
+		char c = quoted[k];
+		if (c == '\\'){
+			k += 1;
+			c = *lex_escape(quoted[k]);
+		}
+		content[length] = c;
+		length += 1;
+	}
+	lit.data.string.content = content;
+	lit.data.string.length = length;
 	return lit;
 }
 
 void
 push_frame(scope* const s){
+	if (s->frame_count == s->frame_capacity){
+		s->frame_stack = pool_require(pool_extend(s->mem, s->frame_stack, sizeof(uint32_t)*s->frame_capacity, sizeof(uint32_t)*s->frame_capacity*2));
+		s->frame_capacity *= 2;
+	}
 	s->frame_stack[s->frame_count] = s->binding_count;
 	s->frame_count += 1;
 }
@@ -1645,12 +3002,20 @@ pop_frame(scope* const s){
 
 void
 push_binding(scope* const s, value_binding binding){
+	if (s->binding_count == s->binding_capacity){
+		s->binding_stack = pool_require(pool_extend(s->mem, s->binding_stack, sizeof(value_binding)*s->binding_capacity, sizeof(value_binding)*s->binding_capacity*2));
+		s->binding_capacity *= 2;
+	}
 	s->binding_stack[s->binding_count] = binding;
 	s->binding_count += 1;
 }
 
 void
 push_label_frame(scope* const s){
+	if (s->label_frame_count == s->label_frame_capacity){
+		s->label_frame_stack = pool_require(pool_extend(s->mem, s->label_frame_stack, sizeof(uint32_t)*s->label_frame_capacity, sizeof(uint32_t)*s->label_frame_capacity*2));
+		s->label_frame_capacity *= 2;
+	}
 	s->label_frame_stack[s->label_frame_count] = s->label_count;
 	s->label_frame_count += 1;
 }
@@ -1663,12 +3028,20 @@ pop_label_frame(scope* const s){
 
 void
 push_label(scope* const s, binding_ast binding){
+	if (s->label_count == s->label_capacity){
+		s->label_stack = pool_require(pool_extend(s->mem, s->label_stack, sizeof(binding_ast)*s->label_capacity, sizeof(binding_ast)*s->label_capacity*2));
+		s->label_capacity *= 2;
+	}
 	s->label_stack[s->label_count] = binding;
 	s->label_count += 1;
 }
 
 void
 push_label_scope(scope* const s){
+	if (s->label_scope_count == s->label_scope_capacity){
+		s->label_scope_stack = pool_require(pool_extend(s->mem, s->label_scope_stack, sizeof(uint32_t)*s->label_scope_capacity, sizeof(uint32_t)*s->label_scope_capacity*2));
+		s->label_scope_capacity *= 2;
+	}
 	s->label_scope_stack[s->label_scope_count] = s->label_count;
 	s->label_scope_count += 1;
 }
@@ -1680,21 +3053,21 @@ pop_label_scope(scope* const s){
 
 uint8_t
 is_label_valid(scope* const s, binding_ast destination){
-	uint16_t end = 0;
+	uint32_t end = 0;
 	if (s->label_scope_count != 0){
 		end = s->label_scope_stack[s->label_scope_count-1];
 	}
-	for (uint16_t i = s->label_count;i>end;--i){
+	for (uint32_t i = s->label_count;i>end;--i){
 		const char* a = destination.name.string+1;
 		const char* b = s->label_stack[i-1].name.string;
+		uint32_t a_len = destination.name.len-1;
+		uint32_t b_len = s->label_stack[i-1].name.len;
 		uint8_t found = 1;
-		while (*b != ':' && *a != '\0'){
-			if (*b != *a){
+		for (uint32_t k = 0;k<a_len && k<b_len && b[k] != ':';++k){
+			if (b[k] != a[k]){
 				found = 0;
 				break;
 			}
-			a += 1;
-			b += 1;
 		}
 		if (found == 1){
 			return 1;
@@ -1705,49 +3078,58 @@ is_label_valid(scope* const s, binding_ast destination){
 
 void
 transform_ast(ast* const tree, pool* const mem, char* err){
+	pool* const scratch = pool_segment(mem, SCRATCH_ARENA);
 	scope roll = {
-		.binding_stack = pool_request(mem, MAX_STACK_MEMBERS*sizeof(binding_ast)),
-		.frame_stack = pool_request(mem, MAX_STACK_MEMBERS*sizeof(uint16_t)),
+		.mem = scratch,
+		.binding_stack = pool_require(pool_array(scratch, value_binding, SCOPE_STACK_MIN)),
+		.frame_stack = pool_require(pool_array(scratch, uint32_t, SCOPE_STACK_MIN)),
 		.binding_count=0,
-		.binding_capacity=MAX_STACK_MEMBERS,
+		.binding_capacity=SCOPE_STACK_MIN,
 		.frame_count=0,
-		.frame_capacity=MAX_STACK_MEMBERS,
-		.captures=pool_request(mem, sizeof(capture_stack)),
+		.frame_capacity=SCOPE_STACK_MIN,
+		.captures=pool_require(pool_new(scratch, capture_stack)),
 		.capture_frame=0,
-		.label_stack = pool_request(mem, MAX_STACK_MEMBERS*sizeof(binding_ast)),
+		.label_stack = pool_require(pool_array(scratch, binding_ast, SCOPE_STACK_MIN)),
 		.label_count=0,
-		.label_capacity=MAX_STACK_MEMBERS,
-		.label_frame_stack = pool_request(mem, MAX_STACK_MEMBERS*sizeof(uint16_t)),
-		.label_scope_stack = pool_request(mem, MAX_STACK_MEMBERS*sizeof(uint16_t)),
+		.label_capacity=SCOPE_STACK_MIN,
+		.label_frame_stack = pool_require(pool_array(scratch, uint32_t, SCOPE_STACK_MIN)),
+		.label_scope_stack = pool_require(pool_array(scratch, uint32_t, SCOPE_STACK_MIN)),
 		.label_frame_count=0,
-		.label_frame_capacity=MAX_STACK_MEMBERS,
-		.label_scope_count=0
+		.label_frame_capacity=SCOPE_STACK_MIN,
+		.label_scope_count=0,
+		.label_scope_capacity=SCOPE_STACK_MIN
 	};
 	*roll.captures = (capture_stack){
 		.prev=NULL,
 		.next=NULL,
+		.binding_list=pool_require(pool_array(scratch, binding_ast, SCOPE_STACK_MIN)),
+		.capacity=SCOPE_STACK_MIN,
 		.size=0,
+		.high=0,
 		.binding_count_point=0
 	};
-	push_builtins(&roll, mem);
+	push_builtins(&roll, tree->names, mem);
 	roll.builtin_stack_frame = roll.binding_count;
-	structure_ast_map touched_structs = structure_ast_map_init(mem);
+	// the layout map is only needed until every struct is rolled
+	pool_mark layout = pool_checkpoint(scratch);
+	structure_ast_map touched_structs = structure_ast_map_init(scratch);
 	for (uint32_t i = 0;i<tree->new_type_c;++i){
-		new_type_ast* t = &tree->new_type_v[i];
+		new_type_ast* t = tree->new_type_v[i];
 		if (t->type.tag != STRUCT_TYPE){
 			continue;
 		}
 		if (t->type.param_c > 0){
 			continue;
 		}
-		structure_ast_map_insert(&touched_structs, t->name.string, t->type.data.structure);
+		structure_ast_map_insert(&touched_structs, t->name.sym, t->type.data.structure);
 		roll_data_layout(tree, t->type.data.structure, t->name, &touched_structs, err);
 		if (*err != 0){
 			return;
 		}
 	}
+	pool_rewind(scratch, &layout);
 	for (uint32_t i = 0;i<tree->func_c;++i){
-		function_ast* f = &tree->func_v[i];
+		function_ast* f = tree->func_v[i];
 		if (f->type.param_c > 0){
 			continue;
 		}
@@ -1756,6 +3138,12 @@ transform_ast(ast* const tree, pool* const mem, char* err){
 			return;
 		}
 	}
+	if (tree->stats != NULL){
+		for (capture_stack* frame = roll.captures;frame != NULL;frame = frame->next){
+			mem_slots(tree->stats, CAPTURE_SLOTS, frame->capacity, frame->high, sizeof(binding_ast));
+		}
+	}
+	pool_empty(scratch);
 }
 
 void
@@ -1767,11 +3155,11 @@ roll_data_layout(ast* const tree, structure_ast* const target, token name, struc
 				continue;
 			}
 			while (inner.tag == USER_TYPE){
-				if (strncmp(name.string, inner.data.user.user.string, TOKEN_MAX) == 0){
+				if (name.sym == inner.data.user.user.sym){
 					snprintf(err, ERROR_BUFFER, " Struct nesting error\n");
 					return;
 				}
-				new_type_ast* primitive_new_type = new_type_ast_map_access(&tree->types, inner.data.user.user.string);
+				new_type_ast* primitive_new_type = new_type_ast_map_access(&tree->types, inner.data.user.user.sym);
 				if (primitive_new_type != NULL){
 					inner = primitive_new_type->type;
 					continue;
@@ -1785,11 +3173,11 @@ roll_data_layout(ast* const tree, structure_ast* const target, token name, struc
 				continue;
 			}
 		}
-		if (structure_ast_map_access(touched, inner.data.user.user.string) != NULL){
+		if (structure_ast_map_access(touched, inner.data.user.user.sym) != NULL){
 			continue;
 		}
 		roll_data_layout(tree, inner.data.structure, name, touched, err);
-		structure_ast_map_insert(touched, inner.data.user.user.string, inner.data.structure);
+		structure_ast_map_insert(touched, inner.data.user.user.sym, inner.data.structure);
 		if (*err != 0){
 			return;
 		}
@@ -1863,9 +3251,9 @@ roll_type(scope* const roll, ast* const tree, pool* const mem, type_ast* const t
 		return;
 	case BUFFER_TYPE:
 		if (target->data.buffer.constant == 1){
-			constant_ast* param = constant_ast_map_access(&tree->constants, target->data.buffer.const_binding.string);
+			constant_ast* param = constant_ast_map_access(&tree->constants, target->data.buffer.const_binding.sym);
 			if (param == NULL){
-				snprintf(err, ERROR_BUFFER, " [!] Parameterized '%s' size not bound to constant\n", target->data.buffer.const_binding.string);
+				snprintf(err, ERROR_BUFFER, " [!] Parameterized '%.*s' size not bound to constant\n", (int)target->data.buffer.const_binding.len, target->data.buffer.const_binding.string);
 				return;
 			}
 			if (param->value.type.tag == PRIMITIVE_TYPE && param->value.type.data.primitive == INT_ANY){
@@ -1873,7 +3261,7 @@ roll_type(scope* const roll, ast* const tree, pool* const mem, type_ast* const t
 				target->data.buffer.count = atoi(param->value.name.string);
 			}
 			else{
-				snprintf(err, ERROR_BUFFER, " [!] Parameterized '%s' size bound to non integer constant\n", target->data.buffer.const_binding.string);
+				snprintf(err, ERROR_BUFFER, " [!] Parameterized '%.*s' size bound to non integer constant\n", (int)target->data.buffer.const_binding.len, target->data.buffer.const_binding.string);
 				return;
 			}
 		}
@@ -1905,9 +3293,9 @@ roll_type(scope* const roll, ast* const tree, pool* const mem, type_ast* const t
 void
 monomorphize_structure(scope* const roll, ast* const tree, pool* const mem, type_ast* const target, char* err){
 	type_ast* inner_resolve = NULL;
-	new_type_ast* is_type = new_type_ast_map_access(&tree->types, target->data.user.user.string);
+	new_type_ast* is_type = new_type_ast_map_access(&tree->types, target->data.user.user.sym);
 	if (is_type == NULL){
-		alias_ast* is_alias = alias_ast_map_access(&tree->aliases, target->data.user.user.string);
+		alias_ast* is_alias = alias_ast_map_access(&tree->aliases, target->data.user.user.sym);
 		if (is_alias == NULL){
 			snprintf(err, ERROR_BUFFER, " [!] Parametrict user type was neither defined type or alias\n");
 			return;
@@ -1917,14 +3305,14 @@ monomorphize_structure(scope* const roll, ast* const tree, pool* const mem, type
 	else{
 		inner_resolve = &is_type->type;
 	}
-	mono_entry_structure* new_morph = pool_request(mem, sizeof(mono_entry_structure));
+	mono_entry_structure* new_morph = pool_new(mem, mono_entry_structure);
 	new_morph->t = NULL;
 	new_morph->next = NULL;
 	new_morph->assoc = type_ast_map_init(mem);
 	for (uint8_t i = 0;i<inner_resolve->param_c;++i){
-		type_ast_map_insert(&new_morph->assoc, inner_resolve->param_v[i].string, &target->data.user.param_v[i]);
+		type_ast_map_insert(&new_morph->assoc, inner_resolve->param_v[i].sym, &target->data.user.param_v[i]);
 	}
-	mono_entry_structure* morph = mono_entry_structure_map_access(&tree->monomorph_structures, target->data.user.user.string);
+	mono_entry_structure* morph = mono_entry_structure_map_access(&tree->monomorph_structures, target->data.user.user.sym);
 	token name_copy;
 	type_ast* deep_copy = NULL;
 	while (morph != NULL){
@@ -1941,8 +3329,9 @@ monomorphize_structure(scope* const roll, ast* const tree, pool* const mem, type
 	}
 	if (deep_copy == NULL){
 		token newname = target->data.user.user;
-		newname.string = pool_request(mem, TOKEN_MAX);
-		snprintf(newname.string, TOKEN_MAX, ":STRUCT_MONO_%u", tree->lifted_lambdas);
+		char mono_name[TOKEN_MAX];
+		newname.len = snprintf(mono_name, TOKEN_MAX, ":STRUCT_MONO_%u", tree->lifted_lambdas);
+		newname.sym = intern_copy(tree->names, mono_name, newname.len, &newname.string);
 		tree->lifted_lambdas += 1;
 		type_ast new_deep_copy;
 		deep_type_replace_type(&new_morph->assoc, mem, &new_deep_copy, inner_resolve, err);
@@ -1957,25 +3346,25 @@ monomorphize_structure(scope* const roll, ast* const tree, pool* const mem, type
 				.name=newname,
 				.type=new_deep_copy
 			};
-			tree->alias_v[tree->alias_c] = proxy_alias;
-			deep_copy = &tree->alias_v[tree->alias_c].type;
+			alias_ast* alias = declaration_push(mem, alias_ast, tree->alias_v, tree->alias_c);
+			*alias = proxy_alias;
+			deep_copy = &alias->type;
 			new_morph->t = deep_copy;
-			alias_ast_map_insert(&tree->aliases, tree->alias_v[tree->alias_c].name.string, &tree->alias_v[tree->alias_c]);
-			tree->alias_c += 1;
+			alias_ast_map_insert(&tree->aliases, alias->name.sym, alias);
 		}
 		else {
 			 new_type_ast proxy_type = {
 				.name=newname,
 				.type=new_deep_copy
 			};
-			tree->new_type_v[tree->new_type_c] = proxy_type;
-			deep_copy = &tree->new_type_v[tree->new_type_c].type;
+			new_type_ast* new_type = declaration_push(mem, new_type_ast, tree->new_type_v, tree->new_type_c);
+			*new_type = proxy_type;
+			deep_copy = &new_type->type;
 			new_morph->t = deep_copy;
-			new_type_ast_map_insert(&tree->types, tree->new_type_v[tree->new_type_c].name.string, &tree->new_type_v[tree->new_type_c]);
-			tree->new_type_c += 1;
+			new_type_ast_map_insert(&tree->types, new_type->name.sym, new_type);
 		}
 		if (morph == NULL){
-			mono_entry_structure_map_insert(&tree->monomorph_structures, target->data.user.user.string, new_morph);
+			mono_entry_structure_map_insert(&tree->monomorph_structures, target->data.user.user.sym, new_morph);
 		}
 		else{
 			morph->next = new_morph;
@@ -2113,7 +3502,7 @@ roll_expression(
 		};
 		uint8_t needs_capture = 0;
 		if (scope_contains(roll, &scope_item, &needs_capture) != NULL){
-			snprintf(err, ERROR_BUFFER, " [!] Closure binding with name '%s' already in scope\n", scope_item.name.string);
+			snprintf(err, ERROR_BUFFER, " [!] Closure binding with name '%.*s' already in scope\n", (int)scope_item.name.len, scope_item.name.string);
 			return expected_type;
 		}
 		if (needs_capture == 1){
@@ -2133,31 +3522,27 @@ roll_expression(
 			}
 			pop_label_scope(roll);
 			binding_ast* captured_binds = NULL;
-			uint16_t num_caps = pop_capture_frame(roll, &captured_binds);
+			uint32_t num_caps = pop_capture_frame(roll, &captured_binds);
 			lambda_ast* focus_lambda = &expr->data.closure.func->expression.data.lambda;
+			uint32_t phase = pool_phase(mem, LIFT_PHASE);
 			type_ast captured_type = prepend_captures(desired, captured_binds, num_caps, mem);
-			for (uint32_t i = 0;i<focus_lambda->argc;++i){
-				uint32_t index = focus_lambda->argc-(i+1);
-				focus_lambda->argv[index+num_caps] = focus_lambda->argv[index];
-			}
-			for (uint32_t i = 0;i<num_caps;++i){
-				focus_lambda->argv[num_caps-(1+i)] = captured_binds[i].name;
-			}
+			focus_lambda->argv = prepend_capture_args(focus_lambda->argv, focus_lambda->argc, captured_binds, num_caps, mem);
 			focus_lambda->argc += num_caps;
 			function_ast lifted_closure = *expr->data.closure.func;
 			lifted_closure.type = captured_type;
-			lifted_closure.name.string = pool_request(mem, TOKEN_MAX);
-			snprintf(lifted_closure.name.string, TOKEN_MAX, ":CLOSURE_%u", tree->lifted_lambdas);
+			char closure_name[TOKEN_MAX];
+			lifted_closure.name.len = snprintf(closure_name, TOKEN_MAX, ":CLOSURE_%u", tree->lifted_lambdas);
+			lifted_closure.name.sym = intern_copy(tree->names, closure_name, lifted_closure.name.len, &lifted_closure.name.string);
 			tree->lifted_lambdas += 1;
-			tree->func_v[tree->func_c] = lifted_closure;
-			function_ast_map_insert(&tree->functions, tree->func_v[tree->func_c].name.string, &tree->func_v[tree->func_c]);
+			function_ast* lifted = declaration_push(mem, function_ast, tree->func_v, tree->func_c);
+			*lifted = lifted_closure;
+			function_ast_map_insert(&tree->functions, lifted->name.sym, lifted);
 			value_binding* prev_pointer = &roll->binding_stack[roll->binding_count-1];
-			prev_pointer->ref = pool_request(mem, sizeof(value_binding));
+			prev_pointer->ref = pool_require(pool_new(pool_segment(mem, SCRATCH_ARENA), value_binding));
 			prev_pointer = prev_pointer->ref;
-			prev_pointer->name=tree->func_v[tree->func_c].name;
-			prev_pointer->type=tree->func_v[tree->func_c].type;
+			prev_pointer->name=lifted->name;
+			prev_pointer->type=lifted->type;
 			prev_pointer->ref=NULL;
-			tree->func_c += 1;
 			binding_ast new_binding = {
 				.type=lifted_closure.type,
 				.name=lifted_closure.name
@@ -2170,7 +3555,7 @@ roll_expression(
 			expression_ast new_application_expr = {
 				.tag=APPLICATION_EXPRESSION,
 				.data.block.expr_c=repl_size,
-				.data.block.expr_v=pool_request(mem, repl_size*sizeof(expression_ast)),
+				.data.block.expr_v=node_array(mem, expression_ast, repl_size),
 				.data.block.type=desired
 			};
 			new_application_expr.data.block.expr_v[0] = new_binding_expr;
@@ -2182,6 +3567,7 @@ roll_expression(
 				new_application_expr.data.block.expr_v[repl_size-i] = repl_binding;
 			}
 			expr->data.closure.func->expression = new_application_expr;
+			pool_phase(mem, phase);
 			return expected_type;
 		}
 		push_capture_frame(roll, mem);
@@ -2203,7 +3589,9 @@ roll_expression(
 				expr->data.block.type = only;
 			}
 			if (only.param_c > 0){
+				uint32_t phase = pool_phase(mem, MONOMORPHIZE_PHASE);
 				monomorphize(roll, tree, mem, expr, &expr->data.block.expr_v[0], &expected_type, 0, err);
+				pool_phase(mem, phase);
 				if (*err != 0){
 					return expected_type;
 				}
@@ -2235,7 +3623,9 @@ roll_expression(
 			return expected_type;
 		}
 		if (full_type.param_c > 0){
+			uint32_t phase = pool_phase(mem, MONOMORPHIZE_PHASE);
 			monomorphize(roll, tree, mem, expr, leftmost, &full_type, index, err);
+			pool_phase(mem, phase);
 			if (*err != 0){
 				return expected_type;
 			}
@@ -2285,18 +3675,18 @@ roll_expression(
 		};
 		type_ast* bound_type = scope_contains(roll, &scope_check, &needs_capturing);
 		if (bound_type == NULL){
-			function_ast* bound_function = function_ast_map_access(&tree->functions, expr->data.binding.name.string);
+			function_ast* bound_function = function_ast_map_access(&tree->functions, expr->data.binding.name.sym);
 			if (bound_function != NULL){
 				bound_type = &bound_function->type;
 			}
 			else{
-				constant_ast* bound_constant = constant_ast_map_access(&tree->constants, expr->data.binding.name.string);
+				constant_ast* bound_constant = constant_ast_map_access(&tree->constants, expr->data.binding.name.sym);
 				if (bound_constant != NULL){
 					bound_type = &bound_constant->value.type;
 					needs_capturing = 0; // just in case
 				}
 				else{
-					snprintf(err, ERROR_BUFFER, " [!] Binding '%s' is not defined in current scope\n", expr->data.binding.name.string);
+					snprintf(err, ERROR_BUFFER, " [!] Binding '%.*s' is not defined in current scope\n", (int)expr->data.binding.name.len, expr->data.binding.name.string);
 					return expected_type;
 				}
 			}
@@ -2313,7 +3703,7 @@ roll_expression(
 			type_ast bound_alias = *bound_type;
 			reduce_aliases(tree, &expected_alias, &bound_alias);
 			if (type_applies(&expected_alias, &bound_alias) != 0){
-				snprintf(err, ERROR_BUFFER, " [!] Binding '%s' was not the expected type\n", expr->data.binding.name.string);
+				snprintf(err, ERROR_BUFFER, " [!] Binding '%.*s' was not the expected type\n", (int)expr->data.binding.name.len, expr->data.binding.name.string);
 				return expected_type;
 			}
 		}
@@ -2452,7 +3842,7 @@ roll_expression(
 			uint8_t found = 0;
 			for (uint32_t k = 0;k<target_struct->binding_c;++k){
 				binding_ast target_binding = target_struct->binding_v[k];
-				if (strncmp(term->data.binding.name.string, target_binding.name.string, TOKEN_MAX) == 0){
+				if (term->data.binding.name.sym == target_binding.name.sym){
 					accessed_type = target_binding.type;
 					found = 1;
 					break;
@@ -2518,7 +3908,7 @@ roll_expression(
 			do {
 				for (uint32_t k = 0;k<temp_struct->binding_c;++k){
 					binding_ast target_binding = temp_struct->binding_v[k];
-					if (strncmp(term->data.binding.name.string, target_binding.name.string, TOKEN_MAX) == 0){
+					if (term->data.binding.name.sym == target_binding.name.sym){
 						if (target_binding.type.tag == STRUCT_TYPE){
 							found = 1;
 							access_full_type = target_binding.type;
@@ -2562,7 +3952,7 @@ roll_expression(
 				next_union += 1;
 			} while (next_union <= target_struct.union_c);
 			if (found == 0){
-				snprintf(err, ERROR_BUFFER, " [!] Unable to find structure member '%s'\n", term->data.binding.name.string);
+				snprintf(err, ERROR_BUFFER, " [!] Unable to find structure member '%.*s'\n", (int)term->data.binding.name.len, term->data.binding.name.string);
 				return access_full_type;
 			}
 		}
@@ -2612,7 +4002,7 @@ roll_expression(
 				};
 				if (scope_contains(roll, &scope_item, NULL) != NULL){
 					pop_frame(roll);
-					snprintf(err, ERROR_BUFFER, " [!] Lambda binding with name '%s' already in scope\n", scope_item.name.string);
+					snprintf(err, ERROR_BUFFER, " [!] Lambda binding with name '%.*s' already in scope\n", (int)scope_item.name.len, scope_item.name.string);
 					return expected_type;
 				}
 				push_binding(roll, scope_item);
@@ -2628,9 +4018,11 @@ roll_expression(
 			}
 			if (prevent_lift == 0){
 				binding_ast* captured_bindings = NULL;
-				uint16_t total_captures = pop_capture_frame(roll, &captured_bindings);
+				uint32_t total_captures = pop_capture_frame(roll, &captured_bindings);
+				uint32_t phase = pool_phase(mem, LIFT_PHASE);
 				type_ast captured_type = prepend_captures(outer_copy, captured_bindings, total_captures, mem);
 				lift_lambda(tree, expr, captured_type, captured_bindings, total_captures, mem);
+				pool_phase(mem, phase);
 				expr->data.block.type = outer_copy;
 			}
 			else{
@@ -2661,14 +4053,14 @@ roll_expression(
 				.ref=NULL
 			};
 			if (scope_contains(roll, &scope_item, NULL) != NULL){
-				snprintf(err, ERROR_BUFFER, " [!] Lambda arg binding with name '%s' already in scope\n", scope_item.name.string);
+				snprintf(err, ERROR_BUFFER, " [!] Lambda arg binding with name '%.*s' already in scope\n", (int)scope_item.name.len, scope_item.name.string);
 				pop_frame(roll);
 				return expected_type;
 			}
 			push_binding(roll, scope_item);
 			focus->tag = FUNCTION_TYPE;
-			focus->data.function.left = pool_request(mem, sizeof(type_ast));
-			focus->data.function.right = pool_request(mem, sizeof(type_ast));
+			focus->data.function.left = node_new(mem, type_ast);
+			focus->data.function.right = node_new(mem, type_ast);
 			focus->mut = 0;
 			focus->param_c = 0;
 			focus->param_v = NULL;
@@ -2683,9 +4075,11 @@ roll_expression(
 		*focus = defin;
 		if (prevent_lift == 0){
 			binding_ast* captured_bindings = NULL;
-			uint16_t total_captures = pop_capture_frame(roll, &captured_bindings);
+			uint32_t total_captures = pop_capture_frame(roll, &captured_bindings);
+			uint32_t phase = pool_phase(mem, LIFT_PHASE);
 			type_ast captured_type = prepend_captures(constructed, captured_bindings, total_captures, mem);
 			lift_lambda(tree, expr, captured_type, captured_bindings, total_captures, mem);
+			pool_phase(mem, phase);
 			expr->data.block.type = constructed;
 		}
 		else{
@@ -2708,7 +4102,7 @@ roll_expression(
 			}
 			type_ast temp = unref;
 			unref.tag = POINTER_TYPE;
-			unref.data.pointer = pool_request(mem, sizeof(type_ast));
+			unref.data.pointer = node_new(mem, type_ast);
 			*unref.data.pointer = temp;
 			return unref;
 		}
@@ -2728,11 +4122,11 @@ roll_expression(
 			return cast_left_type;
 		}
 		if (cast_left_type.tag == POINTER_TYPE){
-			cast_left_type.data.pointer = pool_request(mem, sizeof(type_ast));
+			cast_left_type.data.pointer = node_new(mem, type_ast);
 			*cast_left_type.data.pointer = expr->data.cast.type;
 		}
 		else if (cast_left_type.tag == BUFFER_TYPE){
-			cast_left_type.data.buffer.base = pool_request(mem, sizeof(type_ast));
+			cast_left_type.data.buffer.base = node_new(mem, type_ast);
 			*cast_left_type.data.buffer.base = expr->data.cast.type;
 		}
 		else{
@@ -2776,20 +4170,20 @@ monomorphize(scope* const roll, ast* const tree, pool* const mem, expression_ast
 	if (leftmost->tag != BINDING_EXPRESSION){
 		return;
 	}
-	function_ast* bound_function = function_ast_map_access(&tree->functions, leftmost->data.binding.name.string);
+	function_ast* bound_function = function_ast_map_access(&tree->functions, leftmost->data.binding.name.sym);
 	if (bound_function == NULL){
 		token* referenced_closure = scope_contains_reference(roll, &leftmost->data.binding.name);
 		if (referenced_closure == NULL){
-			snprintf(err, ERROR_BUFFER, " [!] Tried to monomorph closure '%s' which does not exist\n", leftmost->data.binding.name.string);
+			snprintf(err, ERROR_BUFFER, " [!] Tried to monomorph closure '%.*s' which does not exist\n", (int)leftmost->data.binding.name.len, leftmost->data.binding.name.string);
 			return;
 		}
-		bound_function = function_ast_map_access(&tree->functions, referenced_closure->string);
+		bound_function = function_ast_map_access(&tree->functions, referenced_closure->sym);
 		if (bound_function == NULL){
-			snprintf(err, ERROR_BUFFER, " [!] Tried to monomorph function binding '%s' which does not exist\n", leftmost->data.binding.name.string);
+			snprintf(err, ERROR_BUFFER, " [!] Tried to monomorph function binding '%.*s' which does not exist\n", (int)leftmost->data.binding.name.len, leftmost->data.binding.name.string);
 			return;
 		}
 	}
-	mono_entry* new_morph = pool_request(mem, sizeof(mono_entry));
+	mono_entry* new_morph = pool_new(mem, mono_entry);
 	new_morph->f=bound_function;
 	new_morph->next=NULL;
 	new_morph->assoc=type_ast_map_init(mem);
@@ -2797,7 +4191,7 @@ monomorphize(scope* const roll, ast* const tree, pool* const mem, expression_ast
 	if (*err != 0){
 		return;
 	}
-	mono_entry* morph = mono_entry_map_access(&tree->monomorphs, leftmost->data.binding.name.string);
+	mono_entry* morph = mono_entry_map_access(&tree->monomorphs, leftmost->data.binding.name.sym);
 	function_ast* deep_copy = NULL;
 	while (morph != NULL){
 		type_ast_map* candidate = &morph->assoc;
@@ -2812,8 +4206,9 @@ monomorphize(scope* const roll, ast* const tree, pool* const mem, expression_ast
 	}
 	if (deep_copy == NULL){
 		token newname = bound_function->name;
-		newname.string = pool_request(mem, TOKEN_MAX);
-		snprintf(newname.string, TOKEN_MAX, ":MONO_%u", tree->lifted_lambdas);
+		char mono_name[TOKEN_MAX];
+		newname.len = snprintf(mono_name, TOKEN_MAX, ":MONO_%u", tree->lifted_lambdas);
+		newname.sym = intern_copy(tree->names, mono_name, newname.len, &newname.string);
 		tree->lifted_lambdas += 1;
 		function_ast new_deep_copy;
 		deep_type_replace(&new_morph->assoc, mem, &new_deep_copy, bound_function, newname, err);
@@ -2822,17 +4217,16 @@ monomorphize(scope* const roll, ast* const tree, pool* const mem, expression_ast
 		}
 		new_deep_copy.type.param_c = 0;
 		new_deep_copy.type.param_v = NULL;
-		tree->func_v[tree->func_c] = new_deep_copy;
-		deep_copy = &tree->func_v[tree->func_c];
-		tree->func_c += 1;
+		deep_copy = declaration_push(mem, function_ast, tree->func_v, tree->func_c);
+		*deep_copy = new_deep_copy;
 		new_morph->f = deep_copy;
 		if (morph == NULL){
-			mono_entry_map_insert(&tree->monomorphs, leftmost->data.binding.name.string, new_morph);
+			mono_entry_map_insert(&tree->monomorphs, leftmost->data.binding.name.sym, new_morph);
 		}
 		else {
 			morph->next = new_morph;
 		}
-		function_ast_map_insert(&tree->functions, newname.string, deep_copy);
+		function_ast_map_insert(&tree->functions, newname.sym, deep_copy);
 		roll_expression(roll, tree, mem, &deep_copy->expression, deep_copy->type, 0, NULL, 1, err);
 		if (*err != 0){
 			return;
@@ -2845,8 +4239,8 @@ monomorphize(scope* const roll, ast* const tree, pool* const mem, expression_ast
 uint8_t
 type_set_equal(type_ast_map* const assoc, type_ast_map* const candidate, token* const param_v, uint8_t param_c){
 	for (uint8_t i = 0;i<param_c;++i){
-		type_ast* const a = type_ast_map_access(assoc, param_v[i].string);
-		type_ast* const b = type_ast_map_access(candidate, param_v[i].string);
+		type_ast* const a = type_ast_map_access(assoc, param_v[i].sym);
+		type_ast* const b = type_ast_map_access(candidate, param_v[i].sym);
 		if ((a == NULL || b == NULL)
 		 && (a != b)){
 			return 0;
@@ -2899,7 +4293,7 @@ clash_validate_return_type(scope* const roll, ast* const tree, pool* const mem,
 		clash_validate_return_type(roll, tree, mem, assoc, ret->data.buffer.base, err);
 		return;
 	case USER_TYPE:
-		type_ast* access = type_ast_map_access(assoc, ret->data.user.user.string);
+		type_ast* access = type_ast_map_access(assoc, ret->data.user.user.sym);
 		if (access != NULL){
 			*ret = *access;
 			return;
@@ -2918,7 +4312,7 @@ clash_validate_return_type(scope* const roll, ast* const tree, pool* const mem,
 		if (*err != 0){
 			return;
 		}
-		mono_entry_structure* morph = mono_entry_structure_map_access(&tree->monomorph_structures, ret->data.user.user.string);
+		mono_entry_structure* morph = mono_entry_structure_map_access(&tree->monomorph_structures, ret->data.user.user.sym);
 		while (morph != NULL){
 			if (type_cmp(&resolved, morph->t) == 0){
 				ret->data.user.user = morph->name;
@@ -2961,7 +4355,7 @@ uint8_t
 clash_find_diff(scope* const roll, ast* const tree, pool* const mem, type_ast_map* const assoc, type_ast* const outer, type_ast* const left_type, type_ast* const arg_type, char* err){
 	if (left_type->tag != arg_type->tag){
 		if (left_type->tag == USER_TYPE){
-			type_ast* access = type_ast_map_access(assoc, left_type->data.user.user.string);
+			type_ast* access = type_ast_map_access(assoc, left_type->data.user.user.sym);
 			if (access != NULL){
 				if (type_cmp(access, arg_type) == 0){
 					return 1;
@@ -2969,14 +4363,14 @@ clash_find_diff(scope* const roll, ast* const tree, pool* const mem, type_ast_ma
 				return 0;
 			}
 			for (uint8_t i = 0;i<outer->param_c;++i){
-				if (strncmp(left_type->data.user.user.string, outer->param_v[i].string, TOKEN_MAX) == 0){
-					type_ast* entry_copy = pool_request(assoc->mem, sizeof(type_ast));
+				if (left_type->data.user.user.sym == outer->param_v[i].sym){
+					type_ast* entry_copy = node_new(assoc->mem, type_ast);
 					char temp_err[ERROR_BUFFER] = "\0";
 					deep_copy_type(assoc->mem, entry_copy, arg_type, temp_err);
 					if (*temp_err != 0){
 						return 0;
 					}
-					type_ast_map_insert(assoc, left_type->data.user.user.string, entry_copy);
+					type_ast_map_insert(assoc, left_type->data.user.user.sym, entry_copy);
 					return 1;
 				}
 			}
@@ -2997,8 +4391,8 @@ clash_find_diff(scope* const roll, ast* const tree, pool* const mem, type_ast_ma
 		return (left_type->data.buffer.count == arg_type->data.buffer.count)
 			&& clash_find_diff(roll, tree, mem, assoc, outer, left_type->data.buffer.base, arg_type->data.buffer.base, err);
 	case USER_TYPE:
-		if (strncmp(left_type->data.user.user.string, arg_type->data.user.user.string, TOKEN_MAX) != 0){
-			type_ast* access = type_ast_map_access(assoc, left_type->data.user.user.string);
+		if (left_type->data.user.user.sym != arg_type->data.user.user.sym){
+			type_ast* access = type_ast_map_access(assoc, left_type->data.user.user.sym);
 			if (access != NULL){
 				if (type_cmp(access, arg_type) == 0){
 					return 1;
@@ -3006,8 +4400,8 @@ clash_find_diff(scope* const roll, ast* const tree, pool* const mem, type_ast_ma
 				return 0;
 			}
 			for (uint8_t i = 0;i<outer->param_c;++i){
-				if (strncmp(left_type->data.user.user.string, outer->param_v[i].string, TOKEN_MAX) == 0){
-					type_ast_map_insert(assoc, left_type->data.user.user.string, arg_type);
+				if (left_type->data.user.user.sym == outer->param_v[i].sym){
+					type_ast_map_insert(assoc, left_type->data.user.user.sym, arg_type);
 					*left_type = *arg_type;
 					return 1;
 				}
@@ -3088,12 +4482,12 @@ deep_type_replace_type(type_ast_map* const assoc, pool* const mem, type_ast* con
 	copy->mut = type->mut;
 	switch (type->tag){
 	case FUNCTION_TYPE:
-		copy->data.function.left = pool_request(mem, sizeof(type_ast));
+		copy->data.function.left = node_new(mem, type_ast);
 		deep_type_replace_type(assoc, mem, copy->data.function.left, type->data.function.left, err);
 		if (*err != 0){
 			return;
 		}
-		copy->data.function.right = pool_request(mem, sizeof(type_ast));
+		copy->data.function.right = node_new(mem, type_ast);
 		deep_type_replace_type(assoc, mem, copy->data.function.right, type->data.function.right, err);
 		return;
 	case PRIMITIVE_TYPE:
@@ -3103,18 +4497,18 @@ deep_type_replace_type(type_ast_map* const assoc, pool* const mem, type_ast* con
 		copy->data.buffer.count = type->data.buffer.count;
 		copy->data.buffer.constant = type->data.buffer.constant;
 		copy->data.buffer.const_binding = type->data.buffer.const_binding;
-		copy->data.buffer.base = pool_request(mem, sizeof(type_ast));
+		copy->data.buffer.base = node_new(mem, type_ast);
 		deep_type_replace_type(assoc, mem, copy->data.buffer.base, type->data.buffer.base, err);
 		return;
 	case USER_TYPE:
-		type_ast* access = type_ast_map_access(assoc, type->data.user.user.string);
+		type_ast* access = type_ast_map_access(assoc, type->data.user.user.sym);
 		if (access != NULL){
 			deep_copy_type(mem, copy, access, err);
 			return;
 		}
 		copy->data.user.user = type->data.user.user;
 		if (type->data.user.param_c > 0){
-			copy->data.user.param_v = pool_request(mem, sizeof(type_ast)*type->data.user.param_c);
+			copy->data.user.param_v = node_array(mem, type_ast, type->data.user.param_c);
 			copy->data.user.param_c = type->data.user.param_c;
 			for (uint8_t i = 0;i<type->data.user.param_c;++i){
 				deep_type_replace_type(assoc, mem, &copy->data.user.param_v[i], &type->data.user.param_v[i], err);
@@ -3125,12 +4519,12 @@ deep_type_replace_type(type_ast_map* const assoc, pool* const mem, type_ast* con
 		}
 		return;
 	case STRUCT_TYPE:
-		copy->data.structure = pool_request(mem, sizeof(structure_ast));
+		copy->data.structure = node_new(mem, structure_ast);
 		deep_type_replace_structure(assoc, mem, copy->data.structure, type->data.structure, err);
 		return;
 	case POINTER_TYPE:
 	case PROCEDURE_TYPE:
-		copy->data.pointer = pool_request(mem, sizeof(type_ast));
+		copy->data.pointer = node_new(mem, type_ast);
 		deep_type_replace_type(assoc, mem, copy->data.pointer, type->data.pointer, err);
 		return;
 	case NONE_TYPE:
@@ -3148,12 +4542,12 @@ deep_copy_type(pool* const mem, type_ast* const copy, type_ast* const type, char
 	copy->param_v = type->param_v;
 	switch (type->tag){
 	case FUNCTION_TYPE:
-		copy->data.function.left = pool_request(mem, sizeof(type_ast));
+		copy->data.function.left = node_new(mem, type_ast);
 		deep_copy_type(mem, copy->data.function.left, type->data.function.left, err);
 		if (*err != 0){
 			return;
 		}
-		copy->data.function.right = pool_request(mem, sizeof(type_ast));
+		copy->data.function.right = node_new(mem, type_ast);
 		deep_copy_type(mem, copy->data.function.right, type->data.function.right, err);
 		return;
 	case PRIMITIVE_TYPE:
@@ -3163,15 +4557,13 @@ deep_copy_type(pool* const mem, type_ast* const copy, type_ast* const type, char
 		copy->data.buffer.count = type->data.buffer.count;
 		copy->data.buffer.constant = type->data.buffer.constant;
 		copy->data.buffer.const_binding = type->data.buffer.const_binding;
-		copy->data.buffer.base = pool_request(mem, sizeof(type_ast));
+		copy->data.buffer.base = node_new(mem, type_ast);
 		deep_copy_type(mem, copy->data.buffer.base, type->data.buffer.base, err);
 		return;
 	case USER_TYPE:
 		copy->data.user.user = type->data.user.user;
-		copy->data.user.user.string = pool_request(mem, type->data.user.user.len);
-		strncpy(copy->data.user.user.string, type->data.user.user.string, copy->data.user.user.len);
 		if (type->data.user.param_c > 0){
-			copy->data.user.param_v = pool_request(mem, sizeof(type_ast)*type->data.user.param_c);
+			copy->data.user.param_v = node_array(mem, type_ast, type->data.user.param_c);
 			copy->data.user.param_c = type->data.user.param_c;
 			for (uint8_t i = 0;i<type->data.user.param_c;++i){
 				deep_copy_type(mem, &copy->data.user.param_v[i], &type->data.user.param_v[i], err);
@@ -3182,12 +4574,12 @@ deep_copy_type(pool* const mem, type_ast* const copy, type_ast* const type, char
 		}
 		return;
 	case STRUCT_TYPE:
-		copy->data.structure = pool_request(mem, sizeof(structure_ast));
+		copy->data.structure = node_new(mem, structure_ast);
 		deep_copy_structure(mem, copy->data.structure, type->data.structure, err);
 		return;
 	case POINTER_TYPE:
 	case PROCEDURE_TYPE:
-		copy->data.pointer = pool_request(mem, sizeof(type_ast));
+		copy->data.pointer = node_new(mem, type_ast);
 		deep_copy_type(mem, copy->data.pointer, type->data.pointer, err);
 		return;
 	case NONE_TYPE:
@@ -3201,7 +4593,7 @@ deep_copy_type(pool* const mem, type_ast* const copy, type_ast* const type, char
 void
 deep_type_replace_structure(type_ast_map* const assoc, pool* const mem, structure_ast* const copy, structure_ast* const structure, char* err){
 	copy->binding_c = structure->binding_c;
-	copy->binding_v = pool_request(mem, sizeof(binding_ast)*copy->binding_c);
+	copy->binding_v = pool_array(mem, binding_ast, copy->binding_c);
 	for (uint32_t i = 0;i<copy->binding_c;++i){
 		deep_type_replace_type(assoc, mem, &copy->binding_v[i].type, &structure->binding_v[i].type, err);
 		if (*err != 0){
@@ -3212,7 +4604,7 @@ deep_type_replace_structure(type_ast_map* const assoc, pool* const mem, structur
 	copy->encoding = structure->encoding;
 	copy->union_c = structure->union_c;
 	copy->tag_v = structure->tag_v;
-	copy->union_v = pool_request(mem, sizeof(structure_ast)*copy->union_c);
+	copy->union_v = node_array(mem, structure_ast, copy->union_c);
 	for (uint32_t i = 0;i<copy->union_c;++i){
 		deep_type_replace_structure(assoc, mem, &copy->union_v[i], &structure->union_v[i], err);
 		if (*err != 0){
@@ -3224,7 +4616,7 @@ deep_type_replace_structure(type_ast_map* const assoc, pool* const mem, structur
 void
 deep_copy_structure(pool* const mem, structure_ast* const copy, structure_ast* const structure, char* err){
 	copy->binding_c = structure->binding_c;
-	copy->binding_v = pool_request(mem, sizeof(binding_ast)*copy->binding_c);
+	copy->binding_v = pool_array(mem, binding_ast, copy->binding_c);
 	for (uint32_t i = 0;i<copy->binding_c;++i){
 		deep_copy_type(mem, &copy->binding_v[i].type, &structure->binding_v[i].type, err);
 		if (*err != 0){
@@ -3235,7 +4627,7 @@ deep_copy_structure(pool* const mem, structure_ast* const copy, structure_ast* c
 	copy->encoding = structure->encoding;
 	copy->union_c = structure->union_c;
 	copy->tag_v = structure->tag_v;
-	copy->union_v = pool_request(mem, sizeof(structure_ast)*copy->union_c);
+	copy->union_v = node_array(mem, structure_ast, copy->union_c);
 	for (uint32_t i = 0;i<copy->union_c;++i){
 		deep_copy_structure(mem, &copy->union_v[i], &structure->union_v[i], err);
 		if (*err != 0){
@@ -3246,7 +4638,7 @@ deep_copy_structure(pool* const mem, structure_ast* const copy, structure_ast* c
 
 function_ast*
 deep_type_replace_function(type_ast_map* const assoc, pool* const mem, function_ast* const f, char* err){
-	function_ast* copy = pool_request(mem, sizeof(function_ast));
+	function_ast* copy = pool_new(mem, function_ast);
 	copy->name = f->name;
 	copy->enclosing = f->enclosing;
 	deep_type_replace_type(assoc, mem, &copy->type, &f->type, err);
@@ -3268,7 +4660,7 @@ deep_type_replace_expression(type_ast_map* const assoc, pool* const mem, express
 		if (*err != 0){
 			return;
 		}
-		copy->data.block.expr_v = pool_request(mem, sizeof(expression_ast)*expr->data.block.expr_c);
+		copy->data.block.expr_v = node_array(mem, expression_ast, expr->data.block.expr_c);
 		copy->data.block.expr_c = expr->data.block.expr_c;
 		for (uint32_t i = 0;i<copy->data.block.expr_c;++i){
 			deep_type_replace_expression(assoc, mem, &copy->data.block.expr_v[i], &expr->data.block.expr_v[i], err);
@@ -3278,7 +4670,7 @@ deep_type_replace_expression(type_ast_map* const assoc, pool* const mem, express
 		}
 		return;
 	case CLOSURE_EXPRESSION:
-		copy->data.closure.capture_v = pool_request(mem, sizeof(binding_ast)*expr->data.closure.capture_c);
+		copy->data.closure.capture_v = pool_array(mem, binding_ast, expr->data.closure.capture_c);
 		copy->data.closure.func = deep_type_replace_function(assoc, mem, expr->data.closure.func, err);
 		copy->data.closure.capture_c = expr->data.closure.capture_c;
 		return;
@@ -3295,7 +4687,7 @@ deep_type_replace_expression(type_ast_map* const assoc, pool* const mem, express
 		return;
 	case LAMBDA_EXPRESSION:
 		copy->data.lambda.argv=expr->data.lambda.argv;
-		copy->data.lambda.expression = pool_request(mem, sizeof(expression_ast));
+		copy->data.lambda.expression = node_new(mem, expression_ast);
 		copy->data.lambda.argc=expr->data.lambda.argc;
 		deep_type_replace_expression(assoc, mem, copy->data.lambda.expression, expr->data.lambda.expression, err);
 		if (*err != 0){
@@ -3307,11 +4699,11 @@ deep_type_replace_expression(type_ast_map* const assoc, pool* const mem, express
 	case ACCESS_EXPRESSION:
 	case RETURN_EXPRESSION:
 	case REF_EXPRESSION:
-		copy->data.deref = pool_request(mem, sizeof(expression_ast));
+		copy->data.deref = node_new(mem, expression_ast);
 		deep_type_replace_expression(assoc, mem, copy->data.deref, expr->data.deref, err);
 		return;
 	case CAST_EXPRESSION:
-		copy->data.cast.target = pool_request(mem, sizeof(expression_ast));
+		copy->data.cast.target = node_new(mem, expression_ast);
 		deep_type_replace_expression(assoc, mem, copy->data.cast.target, expr->data.cast.target, err);
 		if (*err != 0){
 			return;
@@ -3323,7 +4715,7 @@ deep_type_replace_expression(type_ast_map* const assoc, pool* const mem, express
 		if (*err != 0){
 			return;
 		}
-		copy->data.size_of.target = pool_request(mem, sizeof(expression_ast));
+		copy->data.size_of.target = node_new(mem, expression_ast);
 		deep_type_replace_expression(assoc, mem, copy->data.size_of.target, expr->data.size_of.target, err);
 		if (*err != 0){
 			return;
@@ -3350,8 +4742,8 @@ deep_type_replace_statement(type_ast_map* const assoc, pool* const mem, statemen
 	copy.label = state->label;
 	switch (state->tag){
 	case IF_STATEMENT:
-		copy.data.if_statement.predicate = pool_request(mem, sizeof(expression_ast));
-		copy.data.if_statement.branch = pool_request(mem, sizeof(expression_ast));
+		copy.data.if_statement.predicate = node_new(mem, expression_ast);
+		copy.data.if_statement.branch = node_new(mem, expression_ast);
 		deep_type_replace_expression(assoc, mem, copy.data.if_statement.predicate, state->data.if_statement.predicate, err);
 		if (*err != 0){
 			return copy;
@@ -3361,15 +4753,15 @@ deep_type_replace_statement(type_ast_map* const assoc, pool* const mem, statemen
 			return copy;
 		}
 		if (state->data.if_statement.alternate != NULL){
-		copy.data.if_statement.alternate = pool_request(mem, sizeof(expression_ast));
+		copy.data.if_statement.alternate = node_new(mem, expression_ast);
 			deep_type_replace_expression(assoc, mem, copy.data.if_statement.alternate, state->data.if_statement.alternate, err);
 		}
 		return copy;
 	case FOR_STATEMENT:
-		copy.data.for_statement.start = pool_request(mem, sizeof(expression_ast));
-		copy.data.for_statement.end = pool_request(mem, sizeof(expression_ast));
-		copy.data.for_statement.inc = pool_request(mem, sizeof(expression_ast));
-		copy.data.for_statement.procedure = pool_request(mem, sizeof(expression_ast));
+		copy.data.for_statement.start = node_new(mem, expression_ast);
+		copy.data.for_statement.end = node_new(mem, expression_ast);
+		copy.data.for_statement.inc = node_new(mem, expression_ast);
+		copy.data.for_statement.procedure = node_new(mem, expression_ast);
 		deep_type_replace_expression(assoc, mem, copy.data.for_statement.start, state->data.for_statement.start, err);
 		if (*err != 0){
 			return copy;
@@ -3408,7 +4800,7 @@ deep_type_replace_literal(type_ast_map* const assoc, pool* const mem, literal_as
 		return copy;
 	case ARRAY_LITERAL:
 	case STRUCT_LITERAL:
-		copy.data.array.member_v = pool_request(mem, sizeof(expression_ast)*lit->data.array.member_c);
+		copy.data.array.member_v = node_array(mem, expression_ast, lit->data.array.member_c);
 		copy.data.array.member_c = lit->data.array.member_c;
 		for (uint32_t i = 0;i<copy.data.array.member_c;++i){
 			deep_type_replace_expression(assoc, mem, &copy.data.array.member_v[i], &lit->data.array.member_v[i], err);
@@ -3588,26 +4980,20 @@ uint64_t type_size(ast* const tree, type_ast target_type, char* err){
 }
 
 void
-lift_lambda(ast* const tree, expression_ast* expr, type_ast captured_type, binding_ast* captured_bindings, uint16_t total_captures, pool* const mem){
+lift_lambda(ast* const tree, expression_ast* expr, type_ast captured_type, binding_ast* captured_bindings, uint32_t total_captures, pool* const mem){
 	expr->data.lambda.type = captured_type;
 	expression_ast save_lambda = {
 		.tag=LAMBDA_EXPRESSION,
 		.data.lambda=expr->data.lambda
 	};
-	for (uint32_t i = 0;i<save_lambda.data.lambda.argc;++i){
-		uint32_t index = save_lambda.data.lambda.argc-(i+1);
-		save_lambda.data.lambda.argv[index+total_captures] = save_lambda.data.lambda.argv[index];
-	}
-	for (uint32_t i = 0;i<total_captures;++i){
-		save_lambda.data.lambda.argv[total_captures-(1+i)] = captured_bindings[i].name;
-	}
+	save_lambda.data.lambda.argv = prepend_capture_args(save_lambda.data.lambda.argv, save_lambda.data.lambda.argc, captured_bindings, total_captures, mem);
 	save_lambda.data.lambda.argc += total_captures;
+	char lambda_name[TOKEN_MAX];
 	token new_token = {
 		.type=TOKEN_IDENTIFIER,
-		.string=pool_request(mem, TOKEN_MAX)
+		.len=snprintf(lambda_name, TOKEN_MAX, ":LAMBDA_%u", tree->lifted_lambdas)
 	};
-	snprintf(new_token.string, TOKEN_MAX, ":LAMBDA_%u", tree->lifted_lambdas);
-	new_token.len=strlen(new_token.string);
+	new_token.sym = intern_copy(tree->names, lambda_name, new_token.len, &new_token.string);
 	tree->lifted_lambdas += 1;
 	expression_ast repl_lambda_binding = {
 		.tag=BINDING_EXPRESSION,
@@ -3617,7 +5003,7 @@ lift_lambda(ast* const tree, expression_ast* expr, type_ast captured_type, bindi
 	expr->tag = APPLICATION_EXPRESSION;
 	uint32_t repl_size = total_captures+1;
 	expr->data.block.expr_c = repl_size;
-	expr->data.block.expr_v = pool_request(mem, sizeof(expression_ast)*repl_size);
+	expr->data.block.expr_v = node_array(mem, expression_ast, repl_size);
 	expr->data.block.expr_v[0] = repl_lambda_binding;
 	for (uint32_t repl_term = 1;repl_term < repl_size;++repl_term){
 		expression_ast repl_binding = {
@@ -3632,20 +5018,36 @@ lift_lambda(ast* const tree, expression_ast* expr, type_ast captured_type, bindi
 		.name=new_token,
 		.expression=save_lambda
 	};
-	tree->func_v[tree->func_c] = f;
-	function_ast_map_insert(&tree->functions, tree->func_v[tree->func_c].name.string, &tree->func_v[tree->func_c]);
-	tree->func_c += 1;
+	function_ast* lifted = declaration_push(mem, function_ast, tree->func_v, tree->func_c);
+	*lifted = f;
+	function_ast_map_insert(&tree->functions, lifted->name.sym, lifted);
+}
+
+// parsed argument lists are sized exactly, so captured names go into a new list ahead of the originals
+token*
+prepend_capture_args(token* const argv, uint32_t argc, binding_ast* captures, uint32_t total_captures, pool* const mem){
+	if (total_captures == 0){
+		return argv;
+	}
+	token* captured = node_array(mem, token, argc+total_captures);
+	for (uint32_t i = 0;i<total_captures;++i){
+		captured[total_captures-(1+i)] = captures[i].name;
+	}
+	for (uint32_t i = 0;i<argc;++i){
+		captured[total_captures+i] = argv[i];
+	}
+	return captured;
 }
 
 type_ast
-prepend_captures(type_ast start, binding_ast* captures, uint16_t total_captures, pool* const mem){
-	for (uint16_t i = 0;i<total_captures;++i){
+prepend_captures(type_ast start, binding_ast* captures, uint32_t total_captures, pool* const mem){
+	for (uint32_t i = 0;i<total_captures;++i){
 		binding_ast binding = captures[i];
 		type_ast outer = {
 			.tag=FUNCTION_TYPE
 		};
-		outer.data.function.left = pool_request(mem, sizeof(type_ast));
-		outer.data.function.right = pool_request(mem, sizeof(type_ast));
+		outer.data.function.left = node_new(mem, type_ast);
+		outer.data.function.right = node_new(mem, type_ast);
 		*outer.data.function.left = binding.type;
 		*outer.data.function.right = start;
 		start = outer;
@@ -3664,45 +5066,53 @@ push_capture_frame(scope* const roll, pool* const mem){
 		roll->captures = target;
 		return;
 	}
-	target->next = pool_request(mem, sizeof(capture_stack));
+	pool* const scratch = pool_segment(mem, SCRATCH_ARENA);
+	target->next = pool_require(pool_new(scratch, capture_stack));
 	target = target->next;
 	target->prev = roll->captures;
 	target->next = NULL;
+	target->binding_list = pool_require(pool_array(scratch, binding_ast, SCOPE_STACK_MIN));
+	target->capacity = SCOPE_STACK_MIN;
 	target->size = 0;
+	target->high = 0;
 	target->binding_count_point = roll->binding_count;
 	roll->captures = target;
 }
 
-uint16_t
+uint32_t
 pop_capture_frame(scope* const roll, binding_ast** list_result){
 	if (list_result != NULL){
 		*list_result = roll->captures->binding_list;
 	}
-	uint16_t size = roll->captures->size;
+	uint32_t size = roll->captures->size;
 	roll->captures = roll->captures->prev;
 	return size;
 }
 
 void
 push_capture_binding(scope* const roll, binding_ast binding){
-	if (roll->captures->size >= MAX_CAPTURES){
-		fprintf(stderr, "Capture limit exceeded in stack frame\n");
-		return;
-	}
-	for (uint32_t i = 0;i<roll->captures->size;++i){
-		if (strncmp(binding.name.string, roll->captures->binding_list[i].name.string, TOKEN_MAX) == 0){
+	capture_stack* const frame = roll->captures;
+	for (uint32_t i = 0;i<frame->size;++i){
+		if (binding.name.sym == frame->binding_list[i].name.sym){
 			return;
 		}
 	}
-	roll->captures->binding_list[roll->captures->size] = binding;
-	roll->captures->size += 1;
+	if (frame->size == frame->capacity){
+		frame->binding_list = pool_require(pool_extend(roll->mem, frame->binding_list, sizeof(binding_ast)*frame->capacity, sizeof(binding_ast)*frame->capacity*2));
+		frame->capacity *= 2;
+	}
+	frame->binding_list[frame->size] = binding;
+	frame->size += 1;
+	if (frame->size > frame->high){
+		frame->high = frame->size;
+	}
 }
 
 void
 reduce_aliases(ast* const tree, type_ast* left, type_ast* right){
 	while (left->tag == USER_TYPE || right->tag == USER_TYPE){
-		new_type_ast* left_alias = alias_ast_map_access(&tree->aliases, left->data.user.user.string);
-		new_type_ast* right_alias = alias_ast_map_access(&tree->aliases, right->data.user.user.string);
+		new_type_ast* left_alias = alias_ast_map_access(&tree->aliases, left->data.user.user.sym);
+		new_type_ast* right_alias = alias_ast_map_access(&tree->aliases, right->data.user.user.sym);
 		if (left_alias != NULL){
 			*left = left_alias->type;
 			if (right_alias != NULL){
@@ -3722,7 +5132,7 @@ type_ast
 resolve_alias(ast* const tree, type_ast root, char* err){
 	uint8_t found = 0;
 	while (root.tag == USER_TYPE){
-		new_type_ast* primitive_alias = alias_ast_map_access(&tree->aliases, root.data.user.user.string);
+		new_type_ast* primitive_alias = alias_ast_map_access(&tree->aliases, root.data.user.user.sym);
 		if (primitive_alias == NULL){
 			if (found == 0){
 				snprintf(err, ERROR_BUFFER, " [!] Unknown user type or alias\n");
@@ -3738,7 +5148,7 @@ resolve_alias(ast* const tree, type_ast root, char* err){
 type_ast
 resolve_type_or_alias(ast* const tree, type_ast root, char* err){
 	while (root.tag == USER_TYPE){
-		new_type_ast* primitive_new_type = new_type_ast_map_access(&tree->types, root.data.user.user.string);
+		new_type_ast* primitive_new_type = new_type_ast_map_access(&tree->types, root.data.user.user.sym);
 		if (primitive_new_type != NULL){
 			root = primitive_new_type->type;
 			continue;
@@ -3814,7 +5224,7 @@ type_cmp(type_ast* const a, type_ast* const b){
 		return (a->data.buffer.count != b->data.buffer.count)
 			 + type_cmp(a->data.buffer.base, b->data.buffer.base);
 	case USER_TYPE:
-		return strncmp(a->data.user.user.string, b->data.user.user.string, TOKEN_MAX);
+		return a->data.user.user.sym != b->data.user.user.sym;
 	case STRUCT_TYPE:
 		return struct_cmp(a->data.structure, b->data.structure);
 	case NONE_TYPE:
@@ -3864,12 +5274,12 @@ struct_cmp(structure_ast* const a, structure_ast* const b){
 	}
 	for (uint32_t i = 0;i<a->binding_c;++i){
 		if ((type_applies(&a->binding_v[i].type, &b->binding_v[i].type) != 0)
-		 || (strncmp(a->binding_v[i].name.string, b->binding_v[i].name.string, TOKEN_MAX) != 0)){
+		 || (a->binding_v[i].name.sym != b->binding_v[i].name.sym)){
 			return 1;
 		}
 	}
 	for (uint32_t i = 0;i<a->union_c;++i){
-		if ((strncmp(a->tag_v[i].string, b->tag_v[i].string, TOKEN_MAX) != 0)
+		if ((a->tag_v[i].sym != b->tag_v[i].sym)
 		 || (struct_cmp(&a->union_v[i], &b->union_v[i]) != 0)){
 			return 1;
 		}
@@ -3879,8 +5289,8 @@ struct_cmp(structure_ast* const a, structure_ast* const b){
 
 token*
 scope_contains_reference(scope* const roll, token* bound){
-	for (uint16_t i = roll->frame_stack[roll->frame_count-1];roll->binding_count;++i){
-		if (strncmp(roll->binding_stack[i].name.string, bound->string, TOKEN_MAX)==0){
+	for (uint32_t i = roll->frame_stack[roll->frame_count-1];i<roll->binding_count;++i){
+		if (roll->binding_stack[i].name.sym == bound->sym){
 			
 			if (roll->binding_stack[i].ref != NULL){
 				return &roll->binding_stack[i].ref->name;
@@ -3891,12 +5301,13 @@ scope_contains_reference(scope* const roll, token* bound){
 	return NULL;
 }
 
+// the type returned lives in the binding stack, which push_binding may move, so it is read before the next binding is pushed
 type_ast*
 scope_contains(scope* const roll, value_binding* const binding, uint8_t* needs_capturing){
 	if (needs_capturing != NULL){
-		for (uint16_t i = 0;i<roll->binding_count;++i){
-			uint16_t index = roll->binding_count - (i+1);
-			if (strncmp(roll->binding_stack[index].name.string, binding->name.string, TOKEN_MAX) == 0){
+		for (uint32_t i = 0;i<roll->binding_count;++i){
+			uint32_t index = roll->binding_count - (i+1);
+			if (roll->binding_stack[index].name.sym == binding->name.sym){
 				if ((index < roll->captures->binding_count_point)
 				 && (index >= roll->builtin_stack_frame)){
 					*needs_capturing = 1;
@@ -3906,13 +5317,13 @@ scope_contains(scope* const roll, value_binding* const binding, uint8_t* needs_c
 		}
 		return NULL;
 	}
-	for (uint16_t i = roll->frame_stack[roll->frame_count-1];i<roll->binding_count;++i){
-		if (strncmp(roll->binding_stack[i].name.string, binding->name.string, TOKEN_MAX) == 0){
+	for (uint32_t i = roll->frame_stack[roll->frame_count-1];i<roll->binding_count;++i){
+		if (roll->binding_stack[i].name.sym == binding->name.sym){
 			return &roll->binding_stack[i].type;
 		}
 	}
-	for (uint16_t i = 0;i<roll->builtin_stack_frame;++i){
-		if (strncmp(roll->binding_stack[i].name.string, binding->name.string, TOKEN_MAX) == 0){
+	for (uint32_t i = 0;i<roll->builtin_stack_frame;++i){
+		if (roll->binding_stack[i].name.sym == binding->name.sym){
 			return &roll->binding_stack[i].type;
 		}
 	}
@@ -3938,7 +5349,7 @@ roll_statement_expression(
 		if (as_expression == 0){
 			type_ast temp = expected_type;
 			expected_type.tag = PROCEDURE_TYPE;
-			expected_type.data.pointer = pool_request(mem, sizeof(type_ast));
+			expected_type.data.pointer = node_new(mem, type_ast);
 			*expected_type.data.pointer = temp;
 		}
 		type_ast pred = {
@@ -3992,7 +5403,7 @@ roll_statement_expression(
 		}
 		type_ast temp = expected_type;
 		expected_type.tag = PROCEDURE_TYPE;
-		expected_type.data.pointer = pool_request(mem, sizeof(type_ast));
+		expected_type.data.pointer = node_new(mem, type_ast);
 		*expected_type.data.pointer = temp;
 		type_ast range_type = {
 			.tag = PRIMITIVE_TYPE,
@@ -4013,8 +5424,8 @@ roll_statement_expression(
 		}
 		type_ast iter_type = {
 			.tag=FUNCTION_TYPE,
-			.data.function.left=pool_request(mem, sizeof(type_ast)),
-			.data.function.right=pool_request(mem, sizeof(type_ast))
+			.data.function.left=node_new(mem, type_ast),
+			.data.function.right=node_new(mem, type_ast)
 		};
 		*iter_type.data.function.left = range_type;
 		*iter_type.data.function.right = range_type;
@@ -4040,7 +5451,7 @@ roll_statement_expression(
 		}
 		type_ast brktemp = expected_type;
 		expected_type.tag = PROCEDURE_TYPE;
-		expected_type.data.pointer = pool_request(mem, sizeof(type_ast));
+		expected_type.data.pointer = node_new(mem, type_ast);
 		*expected_type.data.pointer = brktemp;
 		if (statement->labeled == 1){
 			if (is_label_valid(roll, statement->label) == 0){
@@ -4058,7 +5469,7 @@ roll_statement_expression(
 		}
 		type_ast cnttemp = expected_type;
 		expected_type.tag = PROCEDURE_TYPE;
-		expected_type.data.pointer = pool_request(mem, sizeof(type_ast));
+		expected_type.data.pointer = node_new(mem, type_ast);
 		*expected_type.data.pointer = cnttemp;
 		if (statement->labeled == 1){
 			if (is_label_valid(roll, statement->label) == 0){
@@ -4094,7 +5505,7 @@ roll_literal_expression(
 		if (expected_type.tag == NONE_TYPE){
 			inner = (type_ast){
 				.tag=POINTER_TYPE,
-				.data.pointer=pool_request(mem, sizeof(type_ast))
+				.data.pointer=node_new(mem, type_ast)
 			};
 			*inner.data.pointer = (type_ast){
 				.tag=PRIMITIVE_TYPE,
@@ -4153,7 +5564,7 @@ roll_literal_expression(
 			}
 			lit->type = (type_ast){
 				.tag=POINTER_TYPE,
-				.data.pointer=pool_request(mem, sizeof(type_ast))
+				.data.pointer=node_new(mem, type_ast)
 			};
 			*lit->type.data.pointer = inner;
 			return lit->type;
@@ -4201,7 +5612,7 @@ roll_literal_expression(
 				return expected_type;
 			}
 			if (inner_struct_type.tag != STRUCT_TYPE){
-				snprintf(err, ERROR_BUFFER, " [!] Struct literal cannot be created for non struct type '%s'\n", expected_type.data.user.user.string);
+				snprintf(err, ERROR_BUFFER, " [!] Struct literal cannot be created for non struct type '%.*s'\n", (int)expected_type.data.user.user.len, expected_type.data.user.user.string);
 				return expected_type;
 			}
 			target_struct = *inner_struct_type.data.structure;
@@ -4227,7 +5638,7 @@ roll_literal_expression(
 			 && (term->data.block.expr_v[0].tag == BINDING_EXPRESSION)){
 				uint8_t skip = 0;
 				for (uint32_t union_index = 0;union_index<target_struct.union_c;++union_index){
-					if (strncmp(term->data.block.expr_v[0].data.binding.name.string, target_struct.tag_v[union_index].string, TOKEN_MAX) == 0){
+					if (term->data.block.expr_v[0].data.binding.name.sym == target_struct.tag_v[union_index].sym){
 						nest[nest_level] = target_struct;
 						target_struct = target_struct.union_v[union_index];
 						stack[nest_level] = data_member;
@@ -4269,78 +5680,231 @@ roll_literal_expression(
 	return expected_type;
 }
 
-void
-hash_keyword(TOKEN_TYPE_TAG_map* keywords, const char* key, TOKEN_TYPE_TAG value){
-	TOKEN_TYPE_TAG* persistent_value = pool_request(keywords->mem, sizeof(TOKEN_TYPE_TAG));
-	*persistent_value = value;
-	TOKEN_TYPE_TAG_map_insert(keywords, key, persistent_value);
+#define KEYWORD(spelling, tag) if (memcmp(string, spelling, len) == 0) return tag
+
+TOKEN_TYPE_TAG
+lex_keyword(const char* const string, uint32_t len, TOKEN_TYPE_TAG fallback){
+	switch (len){
+	case 1:
+		switch (string[0]){
+		case '+': return TOKEN_ADD;
+		case '-': return TOKEN_SUB;
+		case '*': return TOKEN_MUL;
+		case '/': return TOKEN_DIV;
+		case '%': return TOKEN_MOD;
+		case '=': return TOKEN_SET;
+		case '&': return TOKEN_BIT_AND;
+		case '|': return TOKEN_BIT_OR;
+		case '^': return TOKEN_BIT_XOR;
+		case '~': return TOKEN_BIT_COMP;
+		case '!': return TOKEN_BOOL_NOT;
+		}
+		return fallback;
+	case 2:
+		switch (string[0]){
+		case 'i': KEYWORD("if", TOKEN_IF); KEYWORD("i8", TOKEN_I8); break;
+		case 'u': KEYWORD("u8", TOKEN_U8); break;
+		case 'a': KEYWORD("as", TOKEN_CAST); break;
+		case '.':
+			switch (string[1]){
+			case '+': return TOKEN_FLADD;
+			case '-': return TOKEN_FLSUB;
+			case '*': return TOKEN_FLMUL;
+			case '/': return TOKEN_FLDIV;
+			case '<': return TOKEN_FLANGLE_OPEN;
+			case '>': return TOKEN_FLANGLE_CLOSE;
+			}
+			break;
+		case '<': KEYWORD("<<", TOKEN_SHL); KEYWORD("<|", TOKEN_PIPE_LEFT); break;
+		case '>': KEYWORD(">>", TOKEN_SHR); break;
+		case '&': KEYWORD("&&", TOKEN_BOOL_AND); break;
+		case '|': KEYWORD("||", TOKEN_BOOL_OR); KEYWORD("|>", TOKEN_PIPE_RIGHT); break;
+		case '-': KEYWORD("->", TOKEN_FUNC_IMPL); break;
+		case '=': KEYWORD("=>", TOKEN_DEPENDS); break;
+		case '/': KEYWORD("//", TOKEN_COMMENT); KEYWORD("/*", TOKEN_MULTI_OPEN); break;
+		case '*': KEYWORD("*/", TOKEN_MULTI_CLOSE); break;
+		}
+		return fallback;
+	case 3:
+		switch (string[0]){
+		case 'f': KEYWORD("for", TOKEN_FOR); KEYWORD("f32", TOKEN_F32); KEYWORD("f64", TOKEN_F64); break;
+		case 'u': KEYWORD("u16", TOKEN_U16); KEYWORD("u32", TOKEN_U32); KEYWORD("u64", TOKEN_U64); break;
+		case 'i': KEYWORD("i16", TOKEN_I16); KEYWORD("i32", TOKEN_I32); KEYWORD("i64", TOKEN_I64); break;
+		case 'v': KEYWORD("var", TOKEN_MUTABLE); break;
+		case 'p': KEYWORD("ptr", TOKEN_REF); break;
+		case '.':
+			KEYWORD(".<=", TOKEN_FLLESS_EQ);
+			KEYWORD(".>=", TOKEN_FLGREATER_EQ);
+			KEYWORD(".==", TOKEN_FLEQ);
+			KEYWORD(".!=", TOKEN_FLNOT_EQ);
+			break;
+		}
+		return fallback;
+	case 4:
+		switch (string[0]){
+		case 'e': KEYWORD("else", TOKEN_ELSE); break;
+		case 't': KEYWORD("type", TOKEN_TYPE); break;
+		}
+		return fallback;
+	case 5:
+		switch (string[0]){
+		case 'u': KEYWORD("using", TOKEN_IMPORT); break;
+		case 'm': KEYWORD("match", TOKEN_MATCH); break;
+		case 'a': KEYWORD("alias", TOKEN_ALIAS); break;
+		case 'b': KEYWORD("break", TOKEN_BREAK); break;
+		}
+		return fallback;
+	case 6:
+		switch (string[0]){
+		case 'r': KEYWORD("return", TOKEN_RETURN); break;
+		case 's': KEYWORD("sizeof", TOKEN_SIZEOF); break;
+		}
+		return fallback;
+	case 8:
+		switch (string[0]){
+		case 'c': KEYWORD("constant", TOKEN_CONST); KEYWORD("continue", TOKEN_CONTINUE); break;
+		}
+		return fallback;
+	case 9:
+		KEYWORD("procedure", TOKEN_PROC);
+		return fallback;
+	}
+	return fallback;
 }
 
-void
-add_keyword_hashes(TOKEN_TYPE_TAG_map* keywords){
-	hash_keyword(keywords, "if", TOKEN_IF);
-	hash_keyword(keywords, "else", TOKEN_ELSE);
-	hash_keyword(keywords, "for", TOKEN_FOR);
-	hash_keyword(keywords, "using", TOKEN_IMPORT);
-	hash_keyword(keywords, "match", TOKEN_MATCH);
-	hash_keyword(keywords, "return", TOKEN_RETURN);
-	hash_keyword(keywords, "u8", TOKEN_U8);
-	hash_keyword(keywords, "u16", TOKEN_U16);
-	hash_keyword(keywords, "u32", TOKEN_U32);
-	hash_keyword(keywords, "u64", TOKEN_U64);
-	hash_keyword(keywords, "i8", TOKEN_I8);
-	hash_keyword(keywords, "i16", TOKEN_I16);
-	hash_keyword(keywords, "i32", TOKEN_I32);
-	hash_keyword(keywords, "i64", TOKEN_I64);
-	hash_keyword(keywords, "f32", TOKEN_F32);
-	hash_keyword(keywords, "f64", TOKEN_F64);
-	hash_keyword(keywords, "type", TOKEN_TYPE);
-	hash_keyword(keywords, "alias", TOKEN_ALIAS);
-	hash_keyword(keywords, "var", TOKEN_MUTABLE);
-	hash_keyword(keywords, "ptr", TOKEN_REF);
-	hash_keyword(keywords, "procedure", TOKEN_PROC);
-	hash_keyword(keywords, "constant", TOKEN_CONST);
-	hash_keyword(keywords, "as", TOKEN_CAST);
-	hash_keyword(keywords, "sizeof", TOKEN_SIZEOF);
-	hash_keyword(keywords, "break", TOKEN_BREAK);
-	hash_keyword(keywords, "continue", TOKEN_CONTINUE);
-	hash_keyword(keywords, "+", TOKEN_ADD);
-	hash_keyword(keywords, "-", TOKEN_SUB);
-	hash_keyword(keywords, "*", TOKEN_MUL);
-	hash_keyword(keywords, "/", TOKEN_DIV);
-	hash_keyword(keywords, ".+", TOKEN_FLADD);
-	hash_keyword(keywords, ".-", TOKEN_FLSUB);
-	hash_keyword(keywords, ".*", TOKEN_FLMUL);
-	hash_keyword(keywords, "./", TOKEN_FLDIV);
-	hash_keyword(keywords, "%", TOKEN_MOD);
-	hash_keyword(keywords, "<<", TOKEN_SHL);
-	hash_keyword(keywords, ">>", TOKEN_SHR);
-	hash_keyword(keywords, ".<", TOKEN_FLANGLE_OPEN);
-	hash_keyword(keywords, ".>", TOKEN_FLANGLE_CLOSE);
-	hash_keyword(keywords, ".<=", TOKEN_FLLESS_EQ);
-	hash_keyword(keywords, ".>=", TOKEN_FLGREATER_EQ);
-	hash_keyword(keywords, "=", TOKEN_SET);
-	hash_keyword(keywords, ".==", TOKEN_FLEQ);
-	hash_keyword(keywords, ".!=", TOKEN_FLNOT_EQ);
-	hash_keyword(keywords, "&&", TOKEN_BOOL_AND);
-	hash_keyword(keywords, "||", TOKEN_BOOL_OR);
-	hash_keyword(keywords, "&", TOKEN_BIT_AND);
-	hash_keyword(keywords, "|", TOKEN_BIT_OR);
-	hash_keyword(keywords, "^", TOKEN_BIT_XOR);
-	hash_keyword(keywords, "~", TOKEN_BIT_COMP);
-	hash_keyword(keywords, "!", TOKEN_BOOL_NOT);
-	hash_keyword(keywords, "->", TOKEN_FUNC_IMPL);
-	hash_keyword(keywords, "=>", TOKEN_DEPENDS);
-	hash_keyword(keywords, "<|", TOKEN_PIPE_LEFT);
-	hash_keyword(keywords, "|>", TOKEN_PIPE_RIGHT);
-	hash_keyword(keywords, "//", TOKEN_COMMENT);
-	hash_keyword(keywords, "/*", TOKEN_MULTI_OPEN);
-	hash_keyword(keywords, "*/", TOKEN_MULTI_CLOSE);
+#undef KEYWORD
+
+#if defined(LEX_SCALAR)
+// byte loops only, the lexer benchmark builds this way to compare against the vector scans
+#elif defined(__AVX2__)
+typedef __m256i lex_vec;
+#define LEX_VEC_WIDTH 32
+#define LEX_VEC_FULL 0xFFFFFFFF
+#define lex_vec_load(p) _mm256_loadu_si256((const __m256i*)(p))
+#define lex_vec_set(c) _mm256_set1_epi8(c)
+#define lex_vec_eq(a, b) _mm256_cmpeq_epi8(a, b)
+#define lex_vec_gt(a, b) _mm256_cmpgt_epi8(a, b)
+#define lex_vec_and(a, b) _mm256_and_si256(a, b)
+#define lex_vec_or(a, b) _mm256_or_si256(a, b)
+#define lex_vec_mask(v) ((uint32_t)_mm256_movemask_epi8(v))
+#elif defined(__SSE2__)
+typedef __m128i lex_vec;
+#define LEX_VEC_WIDTH 16
+#define LEX_VEC_FULL 0xFFFF
+#define lex_vec_load(p) _mm_loadu_si128((const __m128i*)(p))
+#define lex_vec_set(c) _mm_set1_epi8(c)
+#define lex_vec_eq(a, b) _mm_cmpeq_epi8(a, b)
+#define lex_vec_gt(a, b) _mm_cmpgt_epi8(a, b)
+#define lex_vec_and(a, b) _mm_and_si128(a, b)
+#define lex_vec_or(a, b) _mm_or_si128(a, b)
+#define lex_vec_mask(v) ((uint32_t)_mm_movemask_epi8(v))
+#endif
+
+/* bytes >= 0x80 compare as negative, so the signed range checks below reject them like isalnum does */
+#define lex_vec_range(v, lo, hi) lex_vec_and(lex_vec_gt(v, lex_vec_set((lo)-1)), lex_vec_gt(lex_vec_set((hi)+1), v))
+
+// most runs end within a few bytes, so the vector loop only starts once a run outlasts this prologue
+#define LEX_SHORT_RUN 16
+
+uint64_t
+scan_whitespace(const char* const buffer, uint64_t i, uint64_t size_bytes){
+	for (uint64_t stop = i+LEX_SHORT_RUN;i<size_bytes && i<stop;++i){
+		char c = buffer[i];
+		if (c != ' ' && c != '\n' && c != '\t' && c != '\r'){
+			return i;
+		}
+	}
+#ifdef LEX_VEC_WIDTH
+	for (;i+LEX_VEC_WIDTH<=size_bytes;i+=LEX_VEC_WIDTH){
+		lex_vec chunk = lex_vec_load(buffer+i);
+		lex_vec ws = lex_vec_or(
+			lex_vec_or(lex_vec_eq(chunk, lex_vec_set(' ')), lex_vec_eq(chunk, lex_vec_set('\n'))),
+			lex_vec_or(lex_vec_eq(chunk, lex_vec_set('\t')), lex_vec_eq(chunk, lex_vec_set('\r')))
+		);
+		uint32_t miss = ~lex_vec_mask(ws) & LEX_VEC_FULL;
+		if (miss != 0){
+			return i+__builtin_ctz(miss);
+		}
+	}
+#endif
+	for (;i<size_bytes;++i){
+		char c = buffer[i];
+		if (c != ' ' && c != '\n' && c != '\t' && c != '\r'){
+			return i;
+		}
+	}
+	return i;
+}
+
+uint64_t
+scan_identifier(const char* const buffer, uint64_t i, uint64_t size_bytes){
+	for (uint64_t stop = i+LEX_SHORT_RUN;i<size_bytes && i<stop;++i){
+		char c = buffer[i];
+		if (!isalnum(c) && c != '_'){
+			return i;
+		}
+	}
+#ifdef LEX_VEC_WIDTH
+	for (;i+LEX_VEC_WIDTH<=size_bytes;i+=LEX_VEC_WIDTH){
+		lex_vec chunk = lex_vec_load(buffer+i);
+		lex_vec word = lex_vec_or(
+			lex_vec_or(lex_vec_range(chunk, 'a', 'z'), lex_vec_range(chunk, 'A', 'Z')),
+			lex_vec_or(lex_vec_range(chunk, '0', '9'), lex_vec_eq(chunk, lex_vec_set('_')))
+		);
+		uint32_t miss = ~lex_vec_mask(word) & LEX_VEC_FULL;
+		if (miss != 0){
+			return i+__builtin_ctz(miss);
+		}
+	}
+#endif
+	for (;i<size_bytes;++i){
+		char c = buffer[i];
+		if (!isalnum(c) && c != '_'){
+			return i;
+		}
+	}
+	return i;
+}
+
+uint64_t
+scan_digits(const char* const buffer, uint64_t i, uint64_t size_bytes){
+	for (uint64_t stop = i+LEX_SHORT_RUN;i<size_bytes && i<stop;++i){
+		char c = buffer[i];
+		if (!isdigit(c)){
+			return i;
+		}
+	}
+#ifdef LEX_VEC_WIDTH
+	for (;i+LEX_VEC_WIDTH<=size_bytes;i+=LEX_VEC_WIDTH){
+		lex_vec chunk = lex_vec_load(buffer+i);
+		uint32_t miss = ~lex_vec_mask(lex_vec_range(chunk, '0', '9')) & LEX_VEC_FULL;
+		if (miss != 0){
+			return i+__builtin_ctz(miss);
+		}
+	}
+#endif
+	for (;i<size_bytes;++i){
+		if (!isdigit(buffer[i])){
+			return i;
+		}
+	}
+	return i;
+}
+
+uint64_t
+scan_line(const char* const buffer, uint64_t i, uint64_t size_bytes){
+	if (i >= size_bytes){
+		return i;
+	}
+	const char* end = memchr(buffer+i, '\n', size_bytes-i);
+	if (end == NULL){
+		return size_bytes;
+	}
+	return end-buffer;
 }
 
 uint64_t
 lex_numeric(token* const tok, uint64_t i, const char* const buffer, uint64_t size_bytes){
-	tok->string[tok->len] = buffer[i];
 	tok->len += 1;
 	tok->type = TOKEN_INTEGER;
 	char k = buffer[++i];
@@ -4350,25 +5914,21 @@ lex_numeric(token* const tok, uint64_t i, const char* const buffer, uint64_t siz
 	switch(k){
 	case 'O':
 	case 'o':
-		tok->string[tok->len] = k;
 		tok->len += 1;
 		for (k=buffer[++i];i<size_bytes;k = buffer[++i]){
 			if (k < '0' || k > '7'){
 				return i;
 			}
-			tok->string[tok->len] = k;
 			tok->len += 1;
 		}
 		return i;
 	case 'X':
 	case 'x':
-		tok->string[tok->len] = k;
 		tok->len += 1;
 		for (k=buffer[++i];i<size_bytes;k = buffer[++i]){
 			if ((k >= '0' && k <= '9')
 			 || (k >= 'A' && k <= 'F')
 			 || (k >= 'a' && k <= 'f')){
-				tok->string[tok->len] = k;
 				tok->len += 1;
 				continue;
 			}
@@ -4377,201 +5937,336 @@ lex_numeric(token* const tok, uint64_t i, const char* const buffer, uint64_t siz
 		return i;
 	case 'B':
 	case 'b':
-		tok->string[tok->len] = k;
 		tok->len += 1;
 		for (k=buffer[++i];i<size_bytes;k = buffer[++i]){
 			if (k != '0' && k != '1'){
 				return i;
 			}
-			tok->string[tok->len] = k;
 			tok->len += 1;
 		}
 		return i;
 	case 'e':
 	case 'E':
 		tok->type = TOKEN_FLOAT;
-		tok->string[tok->len] = k;
 		tok->len += 1;
 		k = buffer[++i];
 		if (i >= size_bytes){
 			return i;
 		}
 		if (k == '-'){
-			tok->string[tok->len] = k;
-			tok->len += 1;
-			k = buffer[++i];
-		}
-		for (;i<size_bytes;k=buffer[++i]){
-			if (!isdigit(k)){
-				return i;
-			}
-			tok->string[tok->len] = k;
 			tok->len += 1;
+			i += 1;
 		}
-		return i;
+		uint64_t exponent = scan_digits(buffer, i, size_bytes);
+		tok->len += exponent-i;
+		return exponent;
 	default:
 		uint8_t dec = 0;
-		for (;i<size_bytes;k = buffer[++i]){
-			if (!isdigit(k)){
-				if (k == '.' && dec == 0){
-					dec = 1;
-					tok->type = TOKEN_FLOAT;
-					tok->string[tok->len] = k;
-					tok->len += 1;
-					continue;
+		while (i<size_bytes){
+			uint64_t run = scan_digits(buffer, i, size_bytes);
+			tok->len += run-i;
+			i = run;
+			if (i >= size_bytes){
+				return i;
+			}
+			k = buffer[i];
+			if (k == '.' && dec == 0){
+				dec = 1;
+				tok->type = TOKEN_FLOAT;
+				tok->len += 1;
+				i += 1;
+				continue;
+			}
+			if (k == 'E' || k == 'e'){
+				tok->type = TOKEN_FLOAT;
+				tok->len += 1;
+				k = buffer[++i];
+				if (i >= size_bytes){
+					return i;
 				}
-				if (k == 'E' || k == 'e'){
-					tok->type = TOKEN_FLOAT;
-					tok->string[tok->len] = k;
+				if (k == '-'){
 					tok->len += 1;
-					k = buffer[++i];
-					if (i >= size_bytes){
-						return i;
-					}
-					if (k == '-'){
-						tok->string[tok->len] = k;
-						tok->len += 1;
-						k = buffer[++i];
-					}
-					for (;i<size_bytes;k=buffer[++i]){
-						if (!isdigit(k)){
-							return i;
-						}
-						tok->string[tok->len] = k;
-						tok->len += 1;
-					}
-					return i;
+					i += 1;
 				}
-				return i;
+				run = scan_digits(buffer, i, size_bytes);
+				tok->len += run-i;
+				return run;
 			}
-			tok->string[tok->len] = k;
-			tok->len += 1;
+			return i;
 		}
 		return i;
 	}
 	return i;
 }
 
+const char*
+lex_escape(char c){
+	static const char* const escaped = "\a\b\033\f\n\r\t\v\\\'\"\?";
+	static const char* const escapes = "abefnrtv\\\'\"?";
+	const char* found = strchr(escapes, c);
+	if (c == '\0' || found == NULL){
+		return NULL;
+	}
+	return escaped+(found-escapes);
+}
+
+// the token spans the literal from quote to quote, parse_char_literal decodes it
 uint64_t
 lex_char(token* const tok, uint64_t i, const char* const buffer, uint64_t size_bytes, char* err){
 	tok->type = TOKEN_CHAR;
+	uint64_t start = i;
 	char char_item = buffer[++i];
 	if (i >= size_bytes){
 		snprintf(err, ERROR_BUFFER, "Lexing Error, unexpected end of file\n");
 		return i;
 	}
-	if (char_item == '\\'){
-		char_item = buffer[++i];
-		if (i >= size_bytes){
-			snprintf(err, ERROR_BUFFER, "Lexing Error, unexpected end of file\n");
-			return i;
-		}
-		switch(char_item){
-		case 'a': char_item = '\a'; break;
-		case 'b': char_item = '\b'; break;
-		case 'e': char_item = '\033'; break;
-		case 'f': char_item = '\f'; break;
-		case 'n': char_item = '\n'; break;
-		case 'r': char_item = '\r'; break;
-		case 't': char_item = '\t'; break;
-		case 'v': char_item = '\v'; break;
-		case '\\': char_item = '\\'; break;
-		case '\'': char_item = '\''; break;
-		case '"': char_item = '"'; break;
-		case '?': char_item = '\?'; break;
-		default:
-			snprintf(err, ERROR_BUFFER, "Lexing error unexpected escape character type '\\%c' (%d) \n", char_item, char_item);
-			return i;
-		}
+	if (char_item == '\\'){
+		char_item = buffer[++i];
+		if (i >= size_bytes){
+			snprintf(err, ERROR_BUFFER, "Lexing Error, unexpected end of file\n");
+			return i;
+		}
+		if (lex_escape(char_item) == NULL){
+			snprintf(err, ERROR_BUFFER, "Lexing error unexpected escape character type '\\%c' (%d) \n", char_item, char_item);
+			return i;
+		}
+	}
+	char_item = buffer[++i];
+	if (char_item != '\'' || i >= size_bytes){
+		snprintf(err, ERROR_BUFFER, " Lexing error, expected (') to end character literal\n");
+		return i;
+	}
+	tok->string = buffer+start;
+	tok->len = i-start+1;
+	return i;
+}
+
+// the token spans the literal from quote to quote, escapes are only checked here and decoded by parse_string_literal
+uint64_t
+lex_string(token* const tok, uint64_t i, const char* const buffer, uint64_t size_bytes, char* err){
+	tok->type = TOKEN_STRING;
+	uint64_t start = i;
+	for (char k = buffer[++i];i<size_bytes;k = buffer[++i]){
+		if (k == '\\'){
+			k = buffer[++i];
+			if (i >= size_bytes){
+				snprintf(err, ERROR_BUFFER, "Lexing Error, unexpected end of file when parsing escape character in string literal\n");
+				return i;
+			}
+			if (lex_escape(k) == NULL){
+				snprintf(err, ERROR_BUFFER, "Lexing error unexpected escape character type '\\%c' (%d) \n", k, k);
+				return i;
+			}
+		}
+		else if (k == '"'){
+			break;
+		}
+	}
+	if (i == size_bytes){
+		snprintf(err, ERROR_BUFFER, " Lexing Error, ended file while parsing string literal, expected '\"'\n");
+		return i;
+	}
+	tok->string = buffer+start;
+	tok->len = i-start+1;
+	return i;
+}
+
+interner
+interner_init(void){
+	interner names = {
+		.mem=pool_alloc(INTERN_POOL_SIZE, POOL_DYNAMIC),
+		.symbol_c=0,
+		.symbol_capacity=INTERN_CHUNK,
+		.slot_capacity=INTERN_CHUNK*2,
+		.locking=0
+	};
+	names.symbol_v = malloc(sizeof(symbol)*names.symbol_capacity);
+	names.slot_v = calloc(names.slot_capacity, sizeof(uint32_t));
+	pthread_mutex_init(&names.lock, NULL);
+	return names;
+}
+
+void
+interner_free(interner* const names){
+	free(names->symbol_v);
+	free(names->slot_v);
+	pool_dealloc(&names->mem);
+	pthread_mutex_destroy(&names->lock);
+	names->symbol_v = NULL;
+	names->slot_v = NULL;
+	names->symbol_c = 0;
+}
+
+// symbols point into sources and module pools that do not outlive a compile, so the table is cleared with them
+void
+interner_empty(interner* const names){
+	memset(names->slot_v, 0, sizeof(uint32_t)*names->slot_capacity);
+	names->symbol_c = 0;
+	pool_empty(&names->mem);
+	pool_track(&names->mem, NULL);
+}
+
+uint32_t
+hash_s(const char* const string, uint32_t len){
+	uint32_t hash = 5381;
+	for (uint32_t i = 0;i<len;++i){
+		hash = ((hash<<5)+hash)+string[i];
+	}
+	return hash;
+}
+
+void
+interner_grow(interner* const names){
+	names->symbol_capacity *= 2;
+	names->symbol_v = realloc(names->symbol_v, sizeof(symbol)*names->symbol_capacity);
+	free(names->slot_v);
+	names->slot_capacity *= 2;
+	names->slot_v = calloc(names->slot_capacity, sizeof(uint32_t));
+	uint32_t mask = names->slot_capacity-1;
+	for (uint32_t id = 0;id<names->symbol_c;++id){
+		uint32_t slot = names->symbol_v[id].hash & mask;
+		while (names->slot_v[slot] != 0){
+			slot = (slot+1) & mask;
+		}
+		names->slot_v[slot] = id+1;
+	}
+}
+
+// slots hold symbol id + 1, so zeroed slots read as empty
+uint32_t*
+intern_find(interner* const names, const char* const string, uint32_t len, uint32_t hash){
+	uint32_t mask = names->slot_capacity-1;
+	uint32_t slot = hash & mask;
+	while (names->slot_v[slot] != 0){
+		const symbol* candidate = &names->symbol_v[names->slot_v[slot]-1];
+		if (candidate->hash == hash
+		 && candidate->len == len
+		 && memcmp(candidate->string, string, len) == 0){
+			return &names->slot_v[slot];
+		}
+		slot = (slot+1) & mask;
+	}
+	return &names->slot_v[slot];
+}
+
+uint32_t
+intern_insert(interner* const names, const char* const string, uint32_t len, uint32_t hash){
+	if (names->symbol_c == names->symbol_capacity){
+		interner_grow(names);
+	}
+	uint32_t id = names->symbol_c;
+	names->symbol_v[id] = (symbol){
+		.string=string,
+		.len=len,
+		.hash=hash
+	};
+	names->symbol_c += 1;
+	*intern_find(names, string, len, hash) = id+1;
+	return id;
+}
+
+uint32_t
+intern(interner* const names, const char* const string, uint32_t len){
+	uint32_t hash = hash_s(string, len);
+	if (names->locking == 1){
+		pthread_mutex_lock(&names->lock);
 	}
-	tok->string[tok->len] = char_item;
-	tok->len += 1;
-	char_item = buffer[++i];
-	if (char_item != '\'' || i >= size_bytes){
-		snprintf(err, ERROR_BUFFER, " Lexing error, expected (') to end character literal\n");
-		return i;
+	uint32_t* slot = intern_find(names, string, len, hash);
+	uint32_t id = *slot-1;
+	if (*slot == 0){
+		id = intern_insert(names, string, len, hash);
 	}
-	return i;
+	if (names->locking == 1){
+		pthread_mutex_unlock(&names->lock);
+	}
+	return id;
 }
 
-token*
-lex_cstr(const char* const buffer, uint64_t size_bytes, pool* const mem, uint64_t* token_count, char** string_content, char* err){
-	TOKEN_TYPE_TAG_map keywords = TOKEN_TYPE_TAG_map_init(mem);
-	add_keyword_hashes(&keywords);
-	*token_count = 0;
-	uint64_t token_capacity = sizeof(token)*READ_TOKEN_CHUNK;
-	token* tokens = pool_request(mem, token_capacity);
+// interns a copy of a transient string, stored points at the interned text
+uint32_t
+intern_copy(interner* const names, const char* const string, uint32_t len, const char** const stored){
+	uint32_t hash = hash_s(string, len);
+	if (names->locking == 1){
+		pthread_mutex_lock(&names->lock);
+	}
+	uint32_t* slot = intern_find(names, string, len, hash);
+	uint32_t id = *slot-1;
+	if (*slot == 0){
+		char* copy = pool_require(pool_request(&names->mem, len+1));
+		memcpy(copy, string, len);
+		copy[len] = '\0';
+		id = intern_insert(names, copy, len, hash);
+	}
+	*stored = names->symbol_v[id].string;
+	if (names->locking == 1){
+		pthread_mutex_unlock(&names->lock);
+	}
+	return id;
+}
+
+// len is 24 bits to keep a token at 16 bytes, so a longer span is an error rather than a silently truncated literal
+static uint8_t
+lex_emit(lexer* const lex, token* const out, const token* const tok, uint64_t start, uint64_t end){
+	if (end-start > TOKEN_LEN_MAX){
+		snprintf(lex->err, ERROR_BUFFER, " Lexing Error, token of %lu bytes exceeds the %u byte limit\n", end-start, TOKEN_LEN_MAX);
+		lex->source_index = lex->source_size;
+		return 0;
+	}
+	lex->source_index = end;
+	*out = *tok;
+	return 1;
+}
+
+uint8_t
+lex_next(lexer* const lex, token* const out){
+	const char* const buffer = lex->source;
+	uint64_t size_bytes = lex->source_size;
+	char* err = lex->err;
 	token tok = {
 		.len=0,
-		.string=*string_content
+		.string=buffer
 	};
-	uint64_t i = 0;
+	uint64_t i = lex->source_index;
 	for (char c = buffer[i];i<size_bytes;c = buffer[++i]){
-		*string_content += tok.len+1;
-		tok.string = *string_content;
+		uint64_t start = i;
+		tok.string = buffer+i;
 		tok.len = 0;
-		if (*token_count == token_capacity){
-			token_capacity += sizeof(token)*READ_TOKEN_CHUNK;
-			pool_request(mem, sizeof(token)*READ_TOKEN_CHUNK);
-		}
 		switch (c){
 		case '\n':
 		case ' ':
 		case '\t':
 		case '\r':
+			i = scan_whitespace(buffer, i, size_bytes)-1;
 			continue;
 		default:
 		}
 		if (c=='-'){
 			if (i+1<size_bytes && isdigit(buffer[i+1])){
-				tok.string[tok.len] = c;
 				tok.len += 1;
 				i += 1;
 				i = lex_numeric(&tok, i, buffer, size_bytes);
 				i -= 1;
-				tok.string[tok.len] = '\0';
-				tokens[*token_count] = tok;
-				*token_count += 1;
-				continue;
+				return lex_emit(lex, out, &tok, start, i+1);
 			}
 		}
 		if (isdigit(c)){
 			i = lex_numeric(&tok, i, buffer, size_bytes);
 			i -= 1;
-			tok.string[tok.len] = '\0';
-			tokens[*token_count] = tok;
-			*token_count += 1;
-			continue;
+			return lex_emit(lex, out, &tok, start, i+1);
 		}
 		else if (isalnum(c) || c == '_'){
-			uint32_t identifier_hash = 5381;
-			tok.string[tok.len] = c;
-			tok.len += 1;
 			tok.type = TOKEN_IDENTIFIER;
-			identifier_hash = ((identifier_hash<<5)+identifier_hash)+((int16_t)c);
-			for (char k = buffer[++i];i<size_bytes;k = buffer[++i]){
-				if (!isalnum(k) && k != '_'){
-					if (k == ':'){
-						tok.string[tok.len] = k;
-						tok.len += 1;
-						tok.type = TOKEN_LABEL;
-						i += 1;
-					}
-					break;
-				}
-				tok.string[tok.len] = k;
+			uint64_t run = scan_identifier(buffer, i+1, size_bytes);
+			tok.len = run-i;
+			i = run;
+			if (i<size_bytes && buffer[i] == ':'){
 				tok.len += 1;
-				identifier_hash = ((identifier_hash<<5)+identifier_hash)+((int16_t)k);
+				tok.type = TOKEN_LABEL;
+				i += 1;
 			}
 			i -= 1;
-			tok.string[tok.len] = '\0';
-			TOKEN_TYPE_TAG* iskeyword = TOKEN_TYPE_TAG_map_access_by_hash(&keywords, identifier_hash, tok.string);
-			if (iskeyword != NULL){
-				tok.type = *iskeyword;
-			}
-			tokens[*token_count] = tok;
-			*token_count += 1;
-			continue;
+			tok.type = lex_keyword(tok.string, tok.len, tok.type);
+			return lex_emit(lex, out, &tok, start, i+1);
 		}
 		tok.type = TOKEN_SYMBOL;
 		uint8_t settled = 1;
@@ -4591,55 +6286,18 @@ lex_cstr(const char* const buffer, uint64_t size_bytes, pool* const mem, uint64_
 		case '\'': 
 			i = lex_char(&tok, i, buffer, size_bytes, err);
 			if (*err != 0){
-				return tokens;
+				lex->source_index = size_bytes;
+				return 0;
 			}
-			tok.string[tok.len] = '\0';
-			tokens[*token_count] = tok;
-			*token_count += 1;
-			continue;
+			return lex_emit(lex, out, &tok, start, i+1);
 		case '"':
-			tok.type = TOKEN_STRING;
-			for (char k = buffer[++i];i<size_bytes;k = buffer[++i]){
-				if (k == '\\'){
-					k = buffer[++i];
-					if (i >= size_bytes){
-						snprintf(err, ERROR_BUFFER, "Lexing Error, unexpected end of file when parsing escape character in string literal\n");
-						return tokens;
-					}
-					switch(k){
-					case 'a': k = '\a'; break;
-					case 'b': k = '\b'; break;
-					case 'e': k = '\033'; break;
-					case 'f': k = '\f'; break;
-					case 'n': k = '\n'; break;
-					case 'r': k = '\r'; break;
-					case 't': k = '\t'; break;
-					case 'v': k = '\v'; break;
-					case '\\': k = '\\'; break;
-					case '\'': k = '\''; break;
-					case '"': k = '"'; break;
-					case '?': k = '\?'; break;
-					default:
-						snprintf(err, ERROR_BUFFER, "Lexing error unexpected escape character type '\\%c' (%d) \n", k, k);
-						return tokens;
-					}
-				}
-				else if (k == '"'){
-					break;
-				}
-				tok.string[tok.len] = k;
-				tok.len += 1;
-			}
-			if (i == size_bytes){
-				snprintf(err, ERROR_BUFFER, " Lexing Error, ended file while parsing string literal, expected '\"'\n");
-				return tokens;
+			i = lex_string(&tok, i, buffer, size_bytes, err);
+			if (*err != 0){
+				lex->source_index = size_bytes;
+				return 0;
 			}
-			tok.string[tok.len] = '\0';
-			tokens[*token_count] = tok;
-			*token_count += 1;
-			continue;
+			return lex_emit(lex, out, &tok, start, i+1);
 		case ':':
-			tok.string[tok.len] = c;
 			tok.len += 1;
 			c = buffer[++i];
 			if (isdigit(c)){
@@ -4651,28 +6309,19 @@ lex_cstr(const char* const buffer, uint64_t size_bytes, pool* const mem, uint64_
 				if ((!isalnum(k)) && (k != '_')){
 					break;
 				}
-				tok.string[tok.len] = k;
 				tok.len += 1;
 			}
 			i -= 1;
-			tok.string[tok.len] = '\0';
-			tokens[*token_count] = tok;
-			*token_count += 1;
-			continue;
+			return lex_emit(lex, out, &tok, start, i+1);
 		default:
 			settled = 0;
 			break;
 		}
 		if (settled == 1){
-			tok.string[tok.len] = c;
 			tok.len += 1;
-			tok.string[tok.len] = '\0';
-			tokens[*token_count] = tok;
-			*token_count += 1;
-			continue;
+			return lex_emit(lex, out, &tok, start, i+1);
 		}
 		else if (issymbol(c)){
-			uint32_t symbol_hash = 5381;
 			char k = c;
 			for (;i<size_bytes;k=buffer[++i]){
 				if ((!issymbol(k))
@@ -4685,18 +6334,11 @@ lex_cstr(const char* const buffer, uint64_t size_bytes, pool* const mem, uint64_
 				|| (k == ';')){
 					break;
 				}
-				tok.string[tok.len] = k;
 				tok.len += 1;
-				symbol_hash = ((symbol_hash<<5)+symbol_hash)+((int16_t)k);
-			}
-			tok.string[tok.len] = '\0';
-			TOKEN_TYPE_TAG* iskeyword = TOKEN_TYPE_TAG_map_access_by_hash(&keywords, symbol_hash, tok.string);
-			if (iskeyword != NULL){
-				tok.type = *iskeyword;
 			}
+			tok.type = lex_keyword(tok.string, tok.len, tok.type);
 			if (tok.type == TOKEN_COMMENT){
-				for (;i<size_bytes&&k != '\n';k=buffer[++i]){}
-				i -= 1;
+				i = scan_line(buffer, i, size_bytes)-1;
 				continue;
 			}
 			if (tok.type == TOKEN_MULTI_OPEN){
@@ -4707,65 +6349,495 @@ lex_cstr(const char* const buffer, uint64_t size_bytes, pool* const mem, uint64_
 				continue;
 			}
 			i -= 1;
-			tokens[*token_count] = tok;
-			*token_count += 1;
-			continue;
+			return lex_emit(lex, out, &tok, start, i+1);
 		}
 		if (c == EOF){
 			tok.type = TOKEN_EOF;
-			tokens[*token_count] = tok;
-			*token_count += 1;
+			lex->source_index = size_bytes;
+			*out = tok;
+			return 1;
+		}
+	}
+	lex->source_index = size_bytes;
+	return 0;
+}
+
+// tokens live in a ring indexed by absolute position, capacity stays a power of two
+lexer
+lex_init(const char* const source, uint64_t size_bytes, interner* const names, uint16_t file){
+	lexer lex = {
+		.capacity=READ_TOKEN_CHUNK,
+		.start=0,
+		.end=0,
+		.index=0,
+		.source=source,
+		.source_size=size_bytes,
+		.source_index=0,
+		.names=names,
+		.chunk_v=NULL,
+		.chunk_c=0,
+		.chunk_index=0,
+		.chunk_token=0,
+		.chunk_workers=0,
+		.diag=NULL,
+		.file=file,
+		.err="\0"
+	};
+	lex.tokens = malloc(sizeof(token)*lex.capacity);
+	lex.group_end = malloc(sizeof(uint64_t)*lex.capacity);
+	if (size_bytes >= LEX_PARALLEL_MIN){
+		lex_parallel(&lex);
+	}
+	return lex;
+}
+
+void
+lex_close(lexer* const lex){
+	free(lex->tokens);
+	free(lex->group_end);
+	lex->tokens = NULL;
+	lex->group_end = NULL;
+	lex->capacity = 0;
+	for (;lex->chunk_index<lex->chunk_c;++lex->chunk_index){
+		lex_chunk_free(&lex->chunk_v[lex->chunk_index]);
+	}
+	free(lex->chunk_v);
+	lex->chunk_v = NULL;
+}
+
+void
+lex_grow(lexer* const lex){
+	uint64_t capacity = lex->capacity*2;
+	token* tokens = malloc(sizeof(token)*capacity);
+	uint64_t* group_end = malloc(sizeof(uint64_t)*capacity);
+	for (uint64_t i = lex->start;i<lex->end;++i){
+		tokens[i & (capacity-1)] = lex->tokens[i & (lex->capacity-1)];
+		group_end[i & (capacity-1)] = lex->group_end[i & (lex->capacity-1)];
+	}
+	free(lex->tokens);
+	free(lex->group_end);
+	lex->tokens = tokens;
+	lex->group_end = group_end;
+	lex->capacity = capacity;
+}
+
+uint8_t
+lex_fill(lexer* const lex, uint64_t index){
+	while (lex->end <= index){
+		token tok;
+		if (lex_pull(lex, &tok) == 0){
+			return 0;
+		}
+		tok.sym = intern(lex->names, tok.string, tok.len);
+		if (lex->end-lex->start == lex->capacity){
+			lex_grow(lex);
+		}
+		lex->tokens[lex->end & (lex->capacity-1)] = tok;
+		lex->group_end[lex->end & (lex->capacity-1)] = 0;
+		lex->end += 1;
+	}
+	return 1;
+}
+
+token
+lex_token(lexer* const lex, uint64_t index){
+	if (lex_fill(lex, index) == 0){
+		return (token){
+			.string="",
+			.len=0,
+			.type=TOKEN_EOF
+		};
+	}
+	return lex->tokens[index & (lex->capacity-1)];
+}
+
+// a token sits where its text does in the source, literals included since they span their quotes
+source_pos
+lex_pos(const lexer* const lex, token tok){
+	uintptr_t text = (uintptr_t)tok.string;
+	uintptr_t source = (uintptr_t)lex->source;
+	if (tok.type == TOKEN_EOF){
+		return (source_pos){.offset=lex->source_size, .file=lex->file};
+	}
+	if (text >= source && text <= source+lex->source_size){
+		return (source_pos){.offset=text-source, .file=lex->file};
+	}
+	return (source_pos){.offset=0, .file=0};
+}
+
+uint8_t
+lex_more(lexer* const lex){
+	return lex_fill(lex, lex->index);
+}
+
+// nothing before the current top level declaration is backtracked into again
+void
+lex_release(lexer* const lex){
+	lex->start = lex->index < lex->end ? lex->index : lex->end;
+}
+
+uint8_t
+lex_pull(lexer* const lex, token* const out){
+	while (lex->chunk_v != NULL){
+		if (lex->chunk_index == lex->chunk_c){
+			lex_window(lex);
+			continue;
+		}
+		lex_chunk* chunk = &lex->chunk_v[lex->chunk_index];
+		if (lex->chunk_token < chunk->token_c){
+			*out = chunk->token_v[lex->chunk_token];
+			lex->chunk_token += 1;
+			return 1;
+		}
+		lex_chunk_free(chunk);
+		lex->chunk_index += 1;
+		lex->chunk_token = 0;
+	}
+	return lex_next(lex, out);
+}
+
+// quick pre scan for top level ; outside of literals, comments and brackets, starting where the last window ended
+uint32_t
+lex_split(lexer* const lex, uint32_t max_chunks, uint64_t target){
+	const char* const buffer = lex->source;
+	uint64_t size_bytes = lex->source_size;
+	uint32_t chunk_c = 0;
+	uint64_t start = lex->source_index;
+	int64_t depth = 0;
+	for (uint64_t i = start;i<size_bytes && chunk_c<max_chunks;++i){
+		switch (buffer[i]){
+		case '"':
+			for (++i;i<size_bytes && buffer[i] != '"';++i){
+				if (buffer[i] == '\\'){
+					i += 1;
+				}
+			}
+			break;
+		case '\'':
+			i += (i+1<size_bytes && buffer[i+1] == '\\') ? 3 : 2;
+			break;
+		case '/':
+			if (i+1<size_bytes && buffer[i+1] == '/'){
+				i = scan_line(buffer, i, size_bytes);
+			}
+			else if (i+1<size_bytes && buffer[i+1] == '*'){
+				for (i += 2;i+1<size_bytes && (buffer[i] != '*' || buffer[i+1] != '/');++i){}
+			}
+			break;
+		case '(':
+		case '[':
+		case '{':
+			depth += 1;
+			break;
+		case ')':
+		case ']':
+		case '}':
+			depth -= 1;
+			break;
+		case ';':
+			if (depth == 0 && i+1-start >= target){
+				lex->chunk_v[chunk_c] = (lex_chunk){.start=start, .end=i+1};
+				chunk_c += 1;
+				start = i+1;
+			}
+			break;
+		default:
 			break;
 		}
 	}
-	return tokens;
+	if (chunk_c < max_chunks && start < size_bytes){
+		lex->chunk_v[chunk_c] = (lex_chunk){.start=start, .end=size_bytes};
+		chunk_c += 1;
+		start = size_bytes;
+	}
+	lex->source_index = start;
+	return chunk_c;
 }
 
-int
-compile_file(char* filename){
-	FILE* fd = fopen(filename, "r");
-	if (fd == NULL){
-		fprintf(stderr, "File not found '%s'\n", filename);
+void
+lex_chunk_job(void* const arg, uint32_t index){
+	lexer* const lex = arg;
+	lex_chunk* const chunk = &lex->chunk_v[index];
+	chunk->token_capacity = READ_TOKEN_CHUNK;
+	chunk->token_v = malloc(sizeof(token)*chunk->token_capacity);
+	chunk->token_c = 0;
+	chunk->err[0] = '\0';
+	if (chunk->token_v == NULL){
+		snprintf(chunk->err, ERROR_BUFFER, " <!> Out of memory\n");
+		return;
+	}
+	lexer local = {
+		.source=lex->source,
+		.source_size=chunk->end,
+		.source_index=chunk->start,
+		.file=lex->file,
+		.err="\0"
+	};
+	token tok;
+	while (lex_next(&local, &tok) == 1){
+		if (chunk->token_c == chunk->token_capacity){
+			token* grown = realloc(chunk->token_v, sizeof(token)*chunk->token_capacity*2);
+			if (grown == NULL){
+				snprintf(chunk->err, ERROR_BUFFER, " <!> Out of memory\n");
+				return;
+			}
+			chunk->token_v = grown;
+			chunk->token_capacity *= 2;
+		}
+		chunk->token_v[chunk->token_c] = tok;
+		chunk->token_c += 1;
+	}
+	strncpy(chunk->err, local.err, ERROR_BUFFER);
+}
+
+void
+lex_chunk_free(lex_chunk* const chunk){
+	free(chunk->token_v);
+	chunk->token_v = NULL;
+	chunk->token_c = 0;
+}
+
+// lexes the next window of chunks in parallel, a chunk that did not end exactly on its ; is dropped with everything after it and the serial lexer resumes from its start
+void
+lex_window(lexer* const lex){
+	lex->chunk_c = 0;
+	lex->chunk_index = 0;
+	lex->chunk_token = 0;
+	if (lex->chunk_workers != 0 && lex->source_index < lex->source_size){
+		lex->chunk_c = lex_split(lex, lex->chunk_workers*LEX_CHUNKS_PER_WORKER, LEX_CHUNK_MIN);
+		jobs_run(lex_chunk_job, lex, lex->chunk_c, lex->chunk_workers);
+	}
+	for (uint32_t i = 0;i<lex->chunk_c;++i){
+		lex_chunk* chunk = &lex->chunk_v[i];
+		if (chunk->err[0] == '\0'
+		 && (chunk->end == lex->source_size
+		 || (chunk->token_c != 0
+		 && chunk->token_v[chunk->token_c-1].type == TOKEN_SEMI
+		 && chunk->token_v[chunk->token_c-1].string == lex->source+chunk->end-1))){
+			continue;
+		}
+		lex->source_index = chunk->start;
+		lex->chunk_workers = 0;
+		for (uint32_t k = i;k<lex->chunk_c;++k){
+			lex_chunk_free(&lex->chunk_v[k]);
+		}
+		lex->chunk_c = i;
+		break;
+	}
+	if (lex->chunk_c == 0){
+		free(lex->chunk_v);
+		lex->chunk_v = NULL;
+	}
+}
+
+// only one window of workers*LEX_CHUNKS_PER_WORKER chunks of about LEX_CHUNK_MIN bytes is lexed ahead at a time,
+// and lex_pull frees each chunk once drained, so a large file never holds more than a window of tokens outside the ring
+uint8_t
+lex_parallel(lexer* const lex){
+	uint32_t workers = jobs_workers();
+	if (workers < 2){
+		return 1;
+	}
+	lex->chunk_v = malloc(sizeof(lex_chunk)*workers*LEX_CHUNKS_PER_WORKER);
+	if (lex->chunk_v == NULL){
+		return 1;
+	}
+	lex->chunk_workers = workers;
+	lex->chunk_c = 0;
+	lex->chunk_index = 0;
+	return 0;
+}
+
+uint8_t
+source_open(source_file* const src, const char* const filename){
+	*src = (source_file){
+		.buffer=NULL,
+		.size=0,
+		.capacity=0,
+		.mapped=0
+	};
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1){
 		return 1;
 	}
-	pool read_buffer = pool_alloc(STRING_CONTENT_BUFFER+READ_BUFFER_SIZE+POOL_SIZE, POOL_STATIC);
-	pool_request(&read_buffer, READ_BUFFER_SIZE);
-	uint64_t read_bytes = fread(read_buffer.buffer, sizeof(char), READ_BUFFER_SIZE, fd);
-	fclose(fd);
-	if (read_bytes == READ_BUFFER_SIZE){
-		pool_dealloc(&read_buffer);
-		fprintf(stderr, "file larger than allowed read buffer\n");
+	struct stat info;
+	if (fstat(fd, &info) == -1){
+		close(fd);
+		return 1;
+	}
+	if (S_ISREG(info.st_mode)){
+		uint64_t page = sysconf(_SC_PAGESIZE);
+		uint64_t file_pages = ((info.st_size+page-1)/page)*page;
+		// reserve at least one zeroed byte past the end, the lexer peeks one character ahead
+		src->capacity = ((info.st_size+page)/page)*page;
+		src->buffer = mmap(NULL, src->capacity, PROT_READ, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+		if (src->buffer == MAP_FAILED){
+			close(fd);
+			return 1;
+		}
+		if (file_pages > 0
+		 && mmap(src->buffer, file_pages, PROT_READ, MAP_PRIVATE|MAP_FIXED, fd, 0) == MAP_FAILED){
+			munmap(src->buffer, src->capacity);
+			close(fd);
+			return 1;
+		}
+		close(fd);
+		src->size = info.st_size;
+		src->mapped = 1;
+		return 0;
+	}
+	src->capacity = SOURCE_READ_CHUNK;
+	src->buffer = malloc(src->capacity);
+	while (src->buffer != NULL){
+		if (src->capacity-src->size <= 1){
+			src->capacity *= 2;
+			char* grown = realloc(src->buffer, src->capacity);
+			if (grown == NULL){
+				break;
+			}
+			src->buffer = grown;
+		}
+		ssize_t read_bytes = read(fd, src->buffer+src->size, src->capacity-src->size-1);
+		if (read_bytes <= 0){
+			close(fd);
+			if (read_bytes < 0){
+				source_close(src);
+				return 1;
+			}
+			src->buffer[src->size] = '\0';
+			return 0;
+		}
+		src->size += read_bytes;
+	}
+	free(src->buffer);
+	src->buffer = NULL;
+	close(fd);
+	return 1;
+}
+
+// memchr is vectorized by the c library, so newlines are found a register width at a time rather than per byte
+void
+line_index_build(line_index* const lines, const char* const text, uint64_t size_bytes){
+	uint32_t capacity = LINE_INDEX_CHUNK;
+	lines->line_v = malloc(sizeof(uint32_t)*capacity);
+	lines->line_v[0] = 0;
+	lines->line_c = 1;
+	if (text == NULL){
+		return;
+	}
+	const char* const end = text+size_bytes;
+	for (const char* cursor = text;cursor<end;){
+		const char* newline = memchr(cursor, '\n', end-cursor);
+		if (newline == NULL){
+			return;
+		}
+		if (lines->line_c == capacity){
+			capacity *= 2;
+			lines->line_v = realloc(lines->line_v, sizeof(uint32_t)*capacity);
+		}
+		lines->line_v[lines->line_c] = (newline+1)-text;
+		lines->line_c += 1;
+		cursor = newline+1;
+	}
+}
+
+source_location
+line_index_locate(const line_index* const lines, uint32_t offset){
+	uint32_t low = 0;
+	uint32_t high = lines->line_c;
+	while (high-low > 1){
+		uint32_t mid = low+((high-low)/2);
+		if (lines->line_v[mid] <= offset){
+			low = mid;
+		}
+		else{
+			high = mid;
+		}
+	}
+	return (source_location){.line=low+1, .col=(offset-lines->line_v[low])+1};
+}
+
+void
+source_close(source_file* const src){
+	if (src->mapped == 1){
+		munmap(src->buffer, src->capacity);
+	}
+	else{
+		free(src->buffer);
+	}
+	src->buffer = NULL;
+	src->size = 0;
+	src->capacity = 0;
+}
+
+// map takes POOL_MAP_TAG flags for backing the compile pool and its segments
+// the pool and its segments are dynamic, so a compile larger than POOL_SIZE chains chunks instead of running out
+compiler
+compiler_init(uint8_t map){
+	compiler c = {
+		.mem=pool_map(POOL_SIZE, POOL_DYNAMIC, map),
+		.names=interner_init(),
+		.stats={.phases.phase=PARSE_PHASE},
+		.recover=0,
+		.tree_image=NULL
+	};
+	pool_segments(&c.mem, ARENA_COUNT, ARENA_SIZE);
+	return c;
+}
+
+// hands every arena back without releasing it, chunks grown by earlier compiles stay linked as spares
+void
+compiler_reset(compiler* const c){
+	pool_empty(&c->mem);
+	pool_track(&c->mem, NULL);
+	interner_empty(&c->names);
+	c->stats = (mem_stats){.phases.phase=PARSE_PHASE};
+}
+
+void
+compiler_free(compiler* const c){
+	pool_dealloc(&c->mem);
+	interner_free(&c->names);
+}
+
+int
+compile_file(compiler* const c, char* filename, uint8_t report){
+	source_file src;
+	if (source_open(&src, filename) != 0){
+		fprintf(stderr, "File not found '%s'\n", filename);
 		return 1;
 	}
-	int comp = compile_cstr(&read_buffer, read_bytes);
+	int comp = compile_cstr(c, filename, src.buffer, src.size, report);
+	source_close(&src);
 	return comp;
 }
 
+// name is what diagnostics call the buffer
 int
-compile_cstr(pool* const mem, uint64_t read_bytes){
+compile_cstr(compiler* const c, const char* const name, const char* const buffer, uint64_t read_bytes, uint8_t report){
 	char err[ERROR_BUFFER] = "\0";
-	uint64_t token_count = 0;
-	printf("%lu bytes left\n", mem->left);
-	char* string_content_buffer = pool_request(mem, STRING_CONTENT_BUFFER);
-	token* tokens = lex_cstr(mem->buffer, read_bytes, mem, &token_count, &string_content_buffer, err);
-	printf("Lexed\n");
+	pool* const mem = &c->mem;
+	if (report == 1){
+		pool_track(mem, &c->stats.phases);
+	}
 	printf("%lu bytes left\n", mem->left);
-	if (*err != 0){
-		fprintf(stderr, "Could not compile\n");
-		fprintf(stderr, err);
-		pool_dealloc(mem);
-		return 1;
+	ast tree = parse(buffer, read_bytes, mem, &c->names, c->recover, err);
+	if (report == 1){
+		tree.stats = &c->stats;
 	}
-	ast tree = parse(tokens, mem, token_count, string_content_buffer, err);
-	if (err[0] != '\0'){
+	if (err[0] != '\0' || diagnostic_count(&tree) != 0){
 		fprintf(stderr, "Could not compile\n");
+		show_diagnostics(&tree, name);
 		fprintf(stderr, err);
-		pool_dealloc(mem);
+		mem_report(&tree, mem);
+		close_modules(&tree);
+		compiler_reset(c);
 		return 1;
 	}
 	show_ast(&tree);
 	printf("Parsed\n");
 	printf("%lu bytes left\n", mem->left);
+	pool_phase(mem, ROLL_PHASE);
 	transform_ast(&tree, mem, err);
 	if (*err != 0){
 		fprintf(stderr, "Could not compile\n");
@@ -4773,29 +6845,111 @@ compile_cstr(pool* const mem, uint64_t read_bytes){
 		show_ast(&tree);
 		fprintf(stderr, "Could not compile\n");
 		fprintf(stderr, err);
-		pool_dealloc(mem);
+		mem_report(&tree, mem);
+		close_modules(&tree);
+		compiler_reset(c);
 		return 1;
 	}
 	show_ast(&tree);
 	printf("Compiled\n");
 	printf("%lu bytes left\n", mem->left);
-	pool_dealloc(mem);
-	return 0;
+	int result = 0;
+	if (c->tree_image != NULL){
+		result = tree_image_check(&tree, c->tree_image);
+	}
+	mem_report(&tree, mem);
+	close_modules(&tree);
+	compiler_reset(c);
+	return result;
+}
+
+void
+mem_slots(mem_stats* const stats, SLOT_TAG slot, uint64_t capacity, uint64_t used, uint64_t size){
+	stats->slot_arrays[slot] += 1;
+	stats->slot_reserved[slot] += capacity*size;
+	stats->slot_used[slot] += used*size;
+}
+
+void
+mem_report(const ast* const tree, pool* const mem){
+	mem_stats* const stats = tree->stats;
+	if (stats == NULL){
+		return;
+	}
+	const char* phase_names[PHASE_COUNT] = {"lex", "parse", "roll", "monomorphize", "lambda lift"};
+	const char* arena_names[ARENA_COUNT+1] = {"tokens", "expressions", "types", "structures", "scratch", "general"};
+	const char* slot_names[SLOT_COUNT] = {"MAX_IMPORTS", "captures"};
+	uint64_t phase_bytes[PHASE_COUNT];
+	uint64_t phase_count[PHASE_COUNT];
+	for (uint32_t i = 0;i<PHASE_COUNT;++i){
+		phase_bytes[i] = stats->phases.bytes[i];
+		phase_count[i] = stats->phases.count[i];
+	}
+	phase_bytes[LEX_PHASE] += tree->names->mem.request_bytes;
+	phase_count[LEX_PHASE] += tree->names->mem.request_c;
+	uint64_t arena_bytes[ARENA_COUNT+1] = {0};
+	uint64_t arena_count[ARENA_COUNT+1] = {0};
+	uint64_t arena_chunks[ARENA_COUNT+1] = {0};
+	uint64_t arena_high[ARENA_COUNT+1] = {0};
+	uint64_t ring_bytes = 0;
+	uint64_t cache_bytes = 0;
+	uint32_t cache_c = 0;
+	for (uint32_t i = 0;i<tree->module_c;++i){
+		module* const m = &tree->module_v[i];
+		ring_bytes += m->lex.capacity*(sizeof(token)+sizeof(uint64_t));
+		if (m->cache != NULL){
+			cache_bytes += ((image_header*)m->cache)->size;
+			cache_c += 1;
+		}
+	}
+	// worker arenas are only touched while parsing imports, so they are not attributed through phases
+	for (pool* base = mem;base != NULL;base = base->adopted){
+		for (uint32_t k = 0;k<=ARENA_COUNT;++k){
+			pool* const arena = pool_segment(base, k);
+			if (base != mem){
+				phase_bytes[PARSE_PHASE] += arena->request_bytes;
+				phase_count[PARSE_PHASE] += arena->request_c;
+			}
+			arena_bytes[k] += arena->request_bytes;
+			arena_count[k] += arena->request_c;
+			arena_chunks[k] += pool_chunks(arena);
+			arena_high[k] += arena->high;
+		}
+	}
+	fprintf(stderr, "\n%-16s %12s %12s\n", "phase", "bytes", "allocations");
+	for (uint32_t i = 0;i<PHASE_COUNT;++i){
+		fprintf(stderr, "%-16s %12lu %12lu\n", phase_names[i], phase_bytes[i], phase_count[i]);
+	}
+	uint64_t high = 0;
+	fprintf(stderr, "\n%-16s %12s %12s %8s %12s\n", "node kind", "bytes", "allocations", "chunks", "high water");
+	for (uint32_t k = 0;k<=ARENA_COUNT;++k){
+		fprintf(stderr, "%-16s %12lu %12lu %8lu %12lu\n", arena_names[k], arena_bytes[k], arena_count[k], arena_chunks[k], arena_high[k]);
+		high += arena_high[k];
+	}
+	fprintf(stderr, "%lu bytes high water across pools\n", high);
+	fprintf(stderr, "%lu bytes in token rings\n", ring_bytes);
+	fprintf(stderr, "%lu bytes in %u cached imports\n", cache_bytes, cache_c);
+	mem_slots(stats, IMPORT_SLOTS, MAX_IMPORTS, tree->import_c, sizeof(token));
+	fprintf(stderr, "\n%-16s %8s %12s %12s %12s\n", "capacity", "arrays", "reserved", "used", "wasted");
+	for (uint32_t i = 0;i<SLOT_COUNT;++i){
+		fprintf(stderr, "%-16s %8lu %12lu %12lu %12lu\n", slot_names[i], stats->slot_arrays[i], stats->slot_reserved[i], stats->slot_used[i], stats->slot_reserved[i]-stats->slot_used[i]);
+	}
 }
 
 void
-binary_int_builtin(scope* const roll, pool* const mem, token name){
+binary_int_builtin(scope* const roll, interner* const names, pool* const mem, token name){
+	name.sym = intern(names, name.string, name.len);
 	value_binding builtin = {
 		.name=name,
 		.type={.tag=FUNCTION_TYPE},
 		.ref=NULL
 	};
-	builtin.type.data.function.left = pool_request(mem, sizeof(type_ast));
-	builtin.type.data.function.right = pool_request(mem, sizeof(type_ast));
+	builtin.type.data.function.left = node_new(mem, type_ast);
+	builtin.type.data.function.right = node_new(mem, type_ast);
 	*builtin.type.data.function.left = (type_ast){.tag=PRIMITIVE_TYPE, .data.primitive=INT_ANY};
 	*builtin.type.data.function.right = (type_ast){.tag=FUNCTION_TYPE};
-	builtin.type.data.function.right->data.function.left = pool_request(mem, sizeof(type_ast));
-	builtin.type.data.function.right->data.function.right = pool_request(mem, sizeof(type_ast));
+	builtin.type.data.function.right->data.function.left = node_new(mem, type_ast);
+	builtin.type.data.function.right->data.function.right = node_new(mem, type_ast);
 	*builtin.type.data.function.right->data.function.left = (type_ast){.tag=PRIMITIVE_TYPE, .data.primitive=INT_ANY};
 	*builtin.type.data.function.right->data.function.right = (type_ast){.tag=PRIMITIVE_TYPE, .data.primitive=INT_ANY};
 	push_binding(roll, builtin);
@@ -4808,63 +6962,64 @@ binary_float_builtin(scope* const roll, pool* const mem, token name){
 		.type={.tag=FUNCTION_TYPE},
 		.ref=NULL
 	};
-	builtin.type.data.function.left = pool_request(mem, sizeof(type_ast));
-	builtin.type.data.function.right = pool_request(mem, sizeof(type_ast));
+	builtin.type.data.function.left = node_new(mem, type_ast);
+	builtin.type.data.function.right = node_new(mem, type_ast);
 	*builtin.type.data.function.left = (type_ast){.tag=PRIMITIVE_TYPE, .data.primitive=FLOAT_ANY};
 	*builtin.type.data.function.right = (type_ast){.tag=FUNCTION_TYPE};
-	builtin.type.data.function.right->data.function.left = pool_request(mem, sizeof(type_ast));
-	builtin.type.data.function.right->data.function.right = pool_request(mem, sizeof(type_ast));
+	builtin.type.data.function.right->data.function.left = node_new(mem, type_ast);
+	builtin.type.data.function.right->data.function.right = node_new(mem, type_ast);
 	*builtin.type.data.function.right->data.function.left = (type_ast){.tag=PRIMITIVE_TYPE, .data.primitive=FLOAT_ANY};
 	*builtin.type.data.function.right->data.function.right = (type_ast){.tag=PRIMITIVE_TYPE, .data.primitive=FLOAT_ANY};
 	push_binding(roll, builtin);
 }
 
 void
-unary_int_builtin(scope* const roll, pool* const mem, token name){
+unary_int_builtin(scope* const roll, interner* const names, pool* const mem, token name){
+	name.sym = intern(names, name.string, name.len);
 	value_binding builtin = {
 		.name=name,
 		.type={.tag=FUNCTION_TYPE},
 		.ref=NULL
 	};
-	builtin.type.data.function.left = pool_request(mem, sizeof(type_ast));
-	builtin.type.data.function.right = pool_request(mem, sizeof(type_ast));
+	builtin.type.data.function.left = node_new(mem, type_ast);
+	builtin.type.data.function.right = node_new(mem, type_ast);
 	*builtin.type.data.function.left = (type_ast){.tag=PRIMITIVE_TYPE, .data.primitive=INT_ANY};
 	*builtin.type.data.function.right = (type_ast){.tag=PRIMITIVE_TYPE, .data.primitive=INT_ANY};
 	push_binding(roll, builtin);
 }
 
 void
-push_builtins(scope* const roll, pool* const mem){
-	binary_int_builtin(roll, mem, (token){ .len=1, .string="+", .type=TOKEN_ADD });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string="-", .type=TOKEN_SUB });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string="/", .type=TOKEN_DIV });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string="*", .type=TOKEN_MUL });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string=".+", .type=TOKEN_FLADD });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string=".-", .type=TOKEN_FLSUB });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string="./", .type=TOKEN_FLDIV });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string=".*", .type=TOKEN_FLMUL });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string="%", .type=TOKEN_MOD });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string="<<", .type=TOKEN_SHL });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string=">>", .type=TOKEN_SHR });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string="<", .type=TOKEN_ANGLE_OPEN });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string=">", .type=TOKEN_ANGLE_CLOSE });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string="<=", .type=TOKEN_LESS_EQ });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string=">=", .type=TOKEN_GREATER_EQ });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string="==", .type=TOKEN_EQ });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string="!=", .type=TOKEN_NOT_EQ });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string=".<", .type=TOKEN_FLANGLE_OPEN });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string=".>", .type=TOKEN_FLANGLE_CLOSE });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string=".<=", .type=TOKEN_FLLESS_EQ });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string=".>=", .type=TOKEN_FLGREATER_EQ });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string=".==", .type=TOKEN_FLEQ });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string=".!=", .type=TOKEN_FLNOT_EQ });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string="&&", .type=TOKEN_BOOL_AND });
-	binary_int_builtin(roll, mem, (token){ .len=2, .string="||", .type=TOKEN_BOOL_OR });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string="&", .type=TOKEN_BIT_AND });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string="|", .type=TOKEN_BIT_OR });
-	binary_int_builtin(roll, mem, (token){ .len=1, .string="^", .type=TOKEN_BIT_XOR });
-	unary_int_builtin(roll, mem, (token){ .len=1, .string="~", .type=TOKEN_BIT_COMP });
-	unary_int_builtin(roll, mem, (token){ .len=1, .string="!", .type=TOKEN_BOOL_NOT });
+push_builtins(scope* const roll, interner* const names, pool* const mem){
+	binary_int_builtin(roll, names, mem, (token){ .len=1, .string="+", .type=TOKEN_ADD });
+	binary_int_builtin(roll, names, mem, (token){ .len=1, .string="-", .type=TOKEN_SUB });
+	binary_int_builtin(roll, names, mem, (token){ .len=1, .string="/", .type=TOKEN_DIV });
+	binary_int_builtin(roll, names, mem, (token){ .len=1, .string="*", .type=TOKEN_MUL });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string=".+", .type=TOKEN_FLADD });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string=".-", .type=TOKEN_FLSUB });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string="./", .type=TOKEN_FLDIV });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string=".*", .type=TOKEN_FLMUL });
+	binary_int_builtin(roll, names, mem, (token){ .len=1, .string="%", .type=TOKEN_MOD });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string="<<", .type=TOKEN_SHL });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string=">>", .type=TOKEN_SHR });
+	binary_int_builtin(roll, names, mem, (token){ .len=1, .string="<", .type=TOKEN_ANGLE_OPEN });
+	binary_int_builtin(roll, names, mem, (token){ .len=1, .string=">", .type=TOKEN_ANGLE_CLOSE });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string="<=", .type=TOKEN_LESS_EQ });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string=">=", .type=TOKEN_GREATER_EQ });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string="==", .type=TOKEN_EQ });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string="!=", .type=TOKEN_NOT_EQ });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string=".<", .type=TOKEN_FLANGLE_OPEN });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string=".>", .type=TOKEN_FLANGLE_CLOSE });
+	binary_int_builtin(roll, names, mem, (token){ .len=3, .string=".<=", .type=TOKEN_FLLESS_EQ });
+	binary_int_builtin(roll, names, mem, (token){ .len=3, .string=".>=", .type=TOKEN_FLGREATER_EQ });
+	binary_int_builtin(roll, names, mem, (token){ .len=3, .string=".==", .type=TOKEN_FLEQ });
+	binary_int_builtin(roll, names, mem, (token){ .len=3, .string=".!=", .type=TOKEN_FLNOT_EQ });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string="&&", .type=TOKEN_BOOL_AND });
+	binary_int_builtin(roll, names, mem, (token){ .len=2, .string="||", .type=TOKEN_BOOL_OR });
+	binary_int_builtin(roll, names, mem, (token){ .len=1, .string="&", .type=TOKEN_BIT_AND });
+	binary_int_builtin(roll, names, mem, (token){ .len=1, .string="|", .type=TOKEN_BIT_OR });
+	binary_int_builtin(roll, names, mem, (token){ .len=1, .string="^", .type=TOKEN_BIT_XOR });
+	unary_int_builtin(roll, names, mem, (token){ .len=1, .string="~", .type=TOKEN_BIT_COMP });
+	unary_int_builtin(roll, names, mem, (token){ .len=1, .string="!", .type=TOKEN_BOOL_NOT });
 	//alloc builtin
 	value_binding alloc = {
 		.name.len=strlen("alloc"),
@@ -4873,15 +7028,16 @@ push_builtins(scope* const roll, pool* const mem){
 		.type={.tag=FUNCTION_TYPE},
 		.ref=NULL
 	};
-	alloc.type.data.function.left = pool_request(mem, sizeof(type_ast));
-	alloc.type.data.function.right = pool_request(mem, sizeof(type_ast));
+	alloc.type.data.function.left = node_new(mem, type_ast);
+	alloc.type.data.function.right = node_new(mem, type_ast);
 	*alloc.type.data.function.left = (type_ast){.tag=PRIMITIVE_TYPE, .data.primitive=INT_ANY};
-	*alloc.type.data.function.right = (type_ast){.tag=POINTER_TYPE, .data.pointer=pool_request(mem, sizeof(type_ast))};
+	*alloc.type.data.function.right = (type_ast){.tag=POINTER_TYPE, .data.pointer=node_new(mem, type_ast)};
 	type_ast bytes = {
 		.tag=PRIMITIVE_TYPE,
 		.data.primitive=U8_TYPE
 	};
 	*alloc.type.data.function.right->data.pointer = bytes;
+	alloc.name.sym = intern(names, alloc.name.string, alloc.name.len);
 	push_binding(roll, alloc);
 	//free builtin
 	value_binding dealloc = {
@@ -4891,18 +7047,19 @@ push_builtins(scope* const roll, pool* const mem){
 		.type={.tag=FUNCTION_TYPE},
 		.ref=NULL
 	};
-	dealloc.type.data.function.left = pool_request(mem, sizeof(type_ast));
-	dealloc.type.data.function.right = pool_request(mem, sizeof(type_ast));
-	*dealloc.type.data.function.left = (type_ast){.tag=POINTER_TYPE, .data.pointer=pool_request(mem, sizeof(type_ast))};
+	dealloc.type.data.function.left = node_new(mem, type_ast);
+	dealloc.type.data.function.right = node_new(mem, type_ast);
+	*dealloc.type.data.function.left = (type_ast){.tag=POINTER_TYPE, .data.pointer=node_new(mem, type_ast)};
 	*dealloc.type.data.function.right = (type_ast){.tag=PRIMITIVE_TYPE, .data.primitive=INT_ANY};
 	bytes.tag=INTERNAL_ANY_TYPE;
 	*dealloc.type.data.function.left->data.pointer = bytes;
+	dealloc.name.sym = intern(names, dealloc.name.string, dealloc.name.len);
 	push_binding(roll, dealloc);
 }
 
 void
 show_token(const token* const tok){
-	printf("%.*s ", TOKEN_MAX, tok->string);
+	printf("%.*s ", (int)tok->len, tok->string);
 	fflush(stdout);
 }
 
@@ -4916,31 +7073,59 @@ show_ast(const ast* const tree){
 	printf("\n");
 	for (size_t i = 0;i<tree->const_c;++i){
 		printf("\033[1;34mconstant\033[0m ");
-		show_constant(&tree->const_v[i]);
+		show_constant(tree->const_v[i]);
 		printf("\n");
 	}
 	printf("\n");
 	for (size_t i = 0;i<tree->new_type_c;++i){
 		printf("\033[1;33mtype\033[0m ");
-		show_new_type(&tree->new_type_v[i]);
+		show_new_type(tree->new_type_v[i]);
 		printf("\n");
 	}
 	printf("\n");
 	for (size_t i = 0;i<tree->alias_c;++i){
 		printf("\033[1;33malias\033[0m ");
-		show_alias(&tree->alias_v[i]);
+		show_alias(tree->alias_v[i]);
 		printf("\n");
 	}
 	printf("\n");
 	for (size_t i = 0;i<tree->func_c;++i){
 		printf("\033[1;31mfunction \033[0m");
-		show_function(&tree->func_v[i]);
+		show_function(tree->func_v[i]);
 		printf("\n");
 		printf("\n");
 	}
 	printf("\n");
 }
 
+uint32_t
+diagnostic_count(const ast* const tree){
+	uint32_t count = 0;
+	for (uint32_t i = 0;i<tree->module_c;++i){
+		count += tree->module_v[i].diag.diag_c;
+	}
+	return count;
+}
+
+// syntax errors a recovering parse kept, in module order, each prefixed with its file, root_name for the root module
+void
+show_diagnostics(ast* const tree, const char* const root_name){
+	for (uint32_t i = 0;i<tree->module_c;++i){
+		const module* const m = &tree->module_v[i];
+		for (uint32_t k = 0;k<m->diag.diag_c;++k){
+			const diagnostic* const d = &m->diag.diag_v[k];
+			source_location loc = module_locate(tree, d->pos);
+			if (i == 0){
+				fprintf(stderr, "%s:", root_name);
+			}
+			else{
+				fprintf(stderr, "%.*s.ka:", m->name.len, m->name.string);
+			}
+			fprintf(stderr, "%u:%u :%s", loc.line, loc.col, d->message);
+		}
+	}
+}
+
 void
 indent_n(uint8_t n){
 	for (uint8_t i = 0;i<n;++i){
@@ -5125,7 +7310,7 @@ void
 show_literal(const literal_ast* const lit){
 	switch (lit->tag){
 	case STRING_LITERAL:
-		printf("\"%s\" ", lit->data.string.content);
+		printf("\"%.*s\" ", (int)lit->data.string.length, lit->data.string.content);
 		break;
 	case ARRAY_LITERAL:
 		printf("[ ");
@@ -5277,21 +7462,62 @@ show_function(const function_ast* const func){
 
 int
 main(int argc, char** argv){
-	compile_file("test_mono.ka");
-	return 0;
 	if (argc < 2){
-		fprintf(stderr, "No arguments provided, use -h or -help for a list of options\n\n");
-		return 1;
+		cache_prune(CACHE_MAX_AGE);
+		compiler c = compiler_init(POOL_MAP_NONE);
+		compile_file(&c, "test_mono.ka", 0);
+		compiler_free(&c);
+		return 0;
 	}
 	if (strncmp(argv[1], "-h", TOKEN_MAX) == 0 || strncmp(argv[1], "-help", TOKEN_MAX) == 0){
 		printf("-h, -help    :  Display this list\n");
 		printf("-o, -out     :  Specify output file name\n");
+		printf("--mem-stats  :  Report memory use per phase and node kind\n");
+		printf("--huge-pages :  Back the compile arenas with huge pages\n");
+		printf("--prefault   :  Fault the compile arenas in before compiling\n");
+		printf("--all-errors :  Report every syntax error instead of stopping at the first\n");
+		printf("--clear-cache:  Remove every cached import in " CACHE_DIRECTORY " before compiling\n");
+		printf("--tree-image :  Write the compiled tree to the next argument as an image, then map it back and check it\n");
 		printf("\n");
 		return 0;
 	}
 	char* output = NULL;
-	char* src = NULL;
+	uint16_t src_c = 0;
+	uint8_t report = 0;
+	uint8_t map = POOL_MAP_NONE;
+	uint8_t recover = 0;
+	const char* tree_image = NULL;
+	time_t cache_age = CACHE_MAX_AGE;
 	for (uint16_t i = 1;i<argc;++i){
+		if (strncmp(argv[i], "--mem-stats", TOKEN_MAX) == 0){
+			report = 1;
+			continue;
+		}
+		if (strncmp(argv[i], "--huge-pages", TOKEN_MAX) == 0){
+			map |= POOL_MAP_HUGE;
+			continue;
+		}
+		if (strncmp(argv[i], "--prefault", TOKEN_MAX) == 0){
+			map |= POOL_MAP_PREFAULT;
+			continue;
+		}
+		if (strncmp(argv[i], "--all-errors", TOKEN_MAX) == 0){
+			recover = 1;
+			continue;
+		}
+		if (strncmp(argv[i], "--clear-cache", TOKEN_MAX) == 0){
+			cache_age = 0;
+			continue;
+		}
+		if (strncmp(argv[i], "--tree-image", TOKEN_MAX) == 0){
+			if (i+1 >= argc){
+				fprintf(stderr, "Expected image file after argument %s\n", argv[i]);
+				return 1;
+			}
+			i += 1;
+			tree_image = argv[i];
+			continue;
+		}
 		if (strncmp(argv[i], "-o", TOKEN_MAX) == 0 || strncmp(argv[i], "-out", TOKEN_MAX) == 0){
 			output = argv[i];
 			if (i+1 >= argc){
@@ -5302,16 +7528,24 @@ main(int argc, char** argv){
 			output = argv[i];
 			continue;
 		}
-		src = argv[i];
+		argv[src_c] = argv[i];
+		src_c += 1;
 	}
-	if (src == NULL){
+	cache_prune(cache_age);
+	if (src_c == 0){
+		if (cache_age == 0){
+			return 0;
+		}
 		fprintf(stderr, "No source file specified for compilation\n");
 		return 1;
 	}
-	if (output == NULL){
-		compile_file(src); // TODO output file
-		return 0;
+	(void)output; // TODO output file
+	compiler c = compiler_init(map);
+	c.recover = recover;
+	c.tree_image = tree_image;
+	for (uint16_t i = 0;i<src_c;++i){
+		compile_file(&c, argv[i], report);
 	}
-	compile_file(src);
+	compiler_free(&c);
 	return 0;
 }
@@ -3,27 +3,38 @@
 
 #define TOKEN_MAX 64
 #include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "hashmap.h"
+#include "pool.h"
+#include "jobs.h"
 
-#define READ_BUFFER_SIZE      0x1000000
-#define STRING_CONTENT_BUFFER  0x100000
+#define SOURCE_READ_CHUNK       0x10000
 #define POOL_SIZE             0x1000000
 #define READ_TOKEN_CHUNK         0x1000
-#define MAX_FUNCTIONS 10000
-#define MAX_ALIASES    1000
+#define INTERN_CHUNK              0x400
+#define INTERN_POOL_SIZE       0x100000
+#define LEX_PARALLEL_MIN       0x100000
+#define LEX_CHUNK_MIN           0x40000
+#define LEX_CHUNKS_PER_WORKER 4
 #define MAX_IMPORTS     100
-#define MAX_ARGS 16
+#define MODULE_DECLARATION_CHUNK 64
+#define DIAGNOSTIC_CHUNK 16
+#define LINE_INDEX_CHUNK 256
+#define RECOVER_DEPTH 64
 #define MAX_PARAMS 8
-#define MAX_CAPTURES 256
-#define BLOCK_MAX 256
 #define ERROR_BUFFER 512
-#define MAX_MEMBERS  256
-#define MAX_STACK_MEMBERS 10000
+#define SCOPE_STACK_MIN 64
 #define MAX_STRUCT_NESTING 8
+#define IMAGE_CHUNK 0x10000
+#define IMAGE_MAGIC 0x31474d49414bULL
+#define CACHE_DIRECTORY ".kacache"
+#define CACHE_PATH_MAX 64
+#define CACHE_MAX_AGE (14*24*60*60)
+#define COMPILER_VERSION __DATE__ " " __TIME__
+#define ARENA_SIZE 0x10000
 
-struct pool;
-typedef struct pool pool;
 
 typedef enum TOKEN_TYPES {
 	TOKEN_IDENTIFIER=0,
@@ -117,33 +128,156 @@ typedef enum TOKEN_TYPES {
 	TOKEN_EOF
 } TOKEN_TYPE_TAG;
 
-MAP_DEF(TOKEN_TYPE_TAG)
+// byte offset into the source of module file-1, file 0 marks a token or node the compiler made up
+typedef struct source_pos {
+	uint32_t offset;
+	uint16_t file;
+} source_pos;
 
+// one based, col counts bytes from the start of the line
+typedef struct source_location {
+	uint32_t line;
+	uint32_t col;
+} source_location;
+
+// line_v holds the offset each line starts at, built the first time a position in the module is asked for
+typedef struct line_index {
+	uint32_t* line_v;
+	uint32_t line_c;
+} line_index;
+
+void line_index_build(line_index* const lines, const char* const text, uint64_t size_bytes);
+source_location line_index_locate(const line_index* const lines, uint32_t offset);
+
+#define TOKEN_LEN_MAX 0xFFFFFF
+
+// a token's position is recovered from where its string points, see lex_pos
 typedef struct token {
-	char* string;
-	TOKEN_TYPE_TAG type;
-	uint32_t len;
+	const char* string;
+	uint32_t len : 24;
+	TOKEN_TYPE_TAG type : 8;
+	uint32_t sym;
 } token;
 
+typedef struct symbol {
+	const char* string;
+	uint32_t len;
+	uint32_t hash;
+} symbol;
+
+typedef struct interner {
+	pool mem;
+	symbol* symbol_v;
+	uint32_t* slot_v;
+	uint32_t symbol_c;
+	uint32_t symbol_capacity;
+	uint32_t slot_capacity;
+	pthread_mutex_t lock;
+	uint8_t locking;
+} interner;
+
+interner interner_init(void);
+void interner_free(interner* const names);
+void interner_empty(interner* const names);
+uint32_t hash_s(const char* const string, uint32_t len);
+void interner_grow(interner* const names);
+uint32_t* intern_find(interner* const names, const char* const string, uint32_t len, uint32_t hash);
+uint32_t intern_insert(interner* const names, const char* const string, uint32_t len, uint32_t hash);
+uint32_t intern(interner* const names, const char* const string, uint32_t len);
+uint32_t intern_copy(interner* const names, const char* const string, uint32_t len, const char** const stored);
+
 void show_token(const token* const tok);
 
+typedef struct lex_chunk {
+	uint64_t start;
+	uint64_t end;
+	token* token_v;
+	uint64_t token_c;
+	uint64_t token_capacity;
+	char err[ERROR_BUFFER];
+} lex_chunk;
+
+// a syntax error kept while the parser recovers, tok is the token it failed on
+typedef struct diagnostic {
+	source_pos pos;
+	char message[ERROR_BUFFER];
+} diagnostic;
+
+typedef struct diagnostics {
+	diagnostic* diag_v;
+	uint32_t diag_c;
+	uint32_t diag_capacity;
+} diagnostics;
+
+// group_end runs alongside the token ring, it memoizes where each bracket group closes for the parser's lookahead
 typedef struct lexer {
-	token* const tokens;
-	uint64_t token_count;
+	token* tokens;
+	uint64_t* group_end;
+	uint64_t capacity;
+	uint64_t start;
+	uint64_t end;
 	uint64_t index;
+	const char* source;
+	uint64_t source_size;
+	uint64_t source_index;
+	interner* names;
+	lex_chunk* chunk_v;
+	uint32_t chunk_c;
+	uint32_t chunk_index;
+	uint64_t chunk_token;
+	uint32_t chunk_workers;
+	diagnostics* diag;
+	uint16_t file;
+	char err[ERROR_BUFFER];
 } lexer;
 
-uint64_t parse_save(lexer* const lex, pool* const mem);
-void parse_load(lexer* const lex, pool* const mem, uint64_t index);
-
-void hash_keyword(TOKEN_TYPE_TAG_map* keywords, const char* key, TOKEN_TYPE_TAG value);
-void add_keyword_hashes(TOKEN_TYPE_TAG_map* keywords);
+lexer lex_init(const char* const source, uint64_t size_bytes, interner* const names, uint16_t file);
+void lex_close(lexer* const lex);
+void lex_grow(lexer* const lex);
+uint8_t lex_fill(lexer* const lex, uint64_t index);
+token lex_token(lexer* const lex, uint64_t index);
+source_pos lex_pos(const lexer* const lex, token tok);
+uint8_t lex_more(lexer* const lex);
+void lex_release(lexer* const lex);
+uint8_t lex_pull(lexer* const lex, token* const out);
+uint32_t lex_split(lexer* const lex, uint32_t max_chunks, uint64_t target);
+void lex_chunk_job(void* const arg, uint32_t index);
+void lex_chunk_free(lex_chunk* const chunk);
+void lex_window(lexer* const lex);
+uint8_t lex_parallel(lexer* const lex);
+
+uint8_t token_opens(TOKEN_TYPE_TAG type);
+uint8_t token_closes(TOKEN_TYPE_TAG type);
+TOKEN_TYPE_TAG token_closer(TOKEN_TYPE_TAG open);
+uint8_t token_starts_type(TOKEN_TYPE_TAG type);
+uint8_t token_in_type(TOKEN_TYPE_TAG type);
+uint64_t lex_group_end(lexer* const lex, uint64_t index);
+uint8_t predict_function(lexer* const lex);
+uint8_t predict_type(lexer* const lex, TOKEN_TYPE_TAG end_token);
+uint8_t predict_type_group(lexer* const lex, uint64_t open, uint8_t in_struct);
+uint8_t predict_literal(lexer* const lex);
+TOKEN_TYPE_TAG predict_member_end(lexer* const lex, TOKEN_TYPE_TAG close);
+uint8_t predict_union_member(lexer* const lex);
+void diagnostic_push(lexer* const lex, const char* const message);
+uint8_t parse_recover(lexer* const lex, char* const err, uint64_t start, TOKEN_TYPE_TAG close);
+
+TOKEN_TYPE_TAG lex_keyword(const char* const string, uint32_t len, TOKEN_TYPE_TAG fallback);
 
 uint64_t lex_char(token* const tok, uint64_t i, const char* const buffer, uint64_t size_bytes, char* err);
 uint64_t lex_numeric(token* const tok, uint64_t i, const char* const buffer, uint64_t size_bytes);
-token* lex_cstr(const char* const buffer, uint64_t size_bytes, pool* const mem, uint64_t* token_count, char** string_buffer, char* err);
-int compile_file(char* filename);
-int compile_cstr(pool* const read_buffer, uint64_t read_bytes);
+const char* lex_escape(char c);
+uint64_t lex_string(token* const tok, uint64_t i, const char* const buffer, uint64_t size_bytes, char* err);
+uint8_t lex_next(lexer* const lex, token* const out);
+
+typedef struct source_file {
+	char* buffer;
+	uint64_t size;
+	uint64_t capacity;
+	uint8_t mapped;
+} source_file;
+
+uint8_t source_open(source_file* const src, const char* const filename);
+void source_close(source_file* const src);
 
 uint32_t subtype(uint32_t type_index, char* const content);
 uint8_t lex_identifier(const char* const string);
@@ -241,6 +375,7 @@ typedef struct type_ast {
 	} data;
 	uint8_t mut;
 	uint8_t param_c;
+	source_pos pos;
 	token* param_v;
 } type_ast;
 
@@ -305,7 +440,7 @@ typedef struct literal_ast{
 	type_ast type;
 	union {
 		struct {
-			char* content;
+			const char* content;
 			uint32_t length;
 		} string;
 		struct {
@@ -367,6 +502,7 @@ typedef struct expression_ast{
 			uint64_t size;
 		} size_of;
 	} data;
+	source_pos pos;
 } expression_ast;
 
 void show_expression(const expression_ast* const expr, uint8_t indent);
@@ -408,10 +544,10 @@ MAP_DEF(mono_entry_structure)
 
 typedef struct ast{
 	token* import_v;
-	function_ast* func_v;
-	new_type_ast* new_type_v;
-	alias_ast* alias_v;
-	constant_ast* const_v;
+	function_ast** func_v;
+	new_type_ast** new_type_v;
+	alias_ast** alias_v;
+	constant_ast** const_v;
 	function_ast_map functions;
 	new_type_ast_map types;
 	alias_ast_map aliases;
@@ -424,37 +560,257 @@ typedef struct ast{
 	uint32_t alias_c;
 	uint32_t const_c;
 	uint32_t lifted_lambdas;
-	char* string_buffer;
+	struct module* module_v;
+	uint32_t module_c;
+	interner* names;
+	struct mem_stats* stats;
+	uint8_t recover;
 } ast;
 
 void show_ast(const ast* const tree);
+uint32_t diagnostic_count(const ast* const tree);
+void show_diagnostics(ast* const tree, const char* const root_name);
+
+// each kind of node is packed into its own segment of the compile pool, scratch holds roll pass state
+typedef enum ARENA_TAG {
+	TOKEN_ARENA,
+	EXPRESSION_ARENA,
+	TYPE_ARENA,
+	STRUCTURE_ARENA,
+	SCRATCH_ARENA,
+	ARENA_COUNT
+} ARENA_TAG;
+
+#define ARENA_OF(type) _Generic((type*)NULL,\
+	token*: TOKEN_ARENA,\
+	expression_ast*: EXPRESSION_ARENA,\
+	type_ast*: TYPE_ARENA,\
+	structure_ast*: STRUCTURE_ARENA,\
+	default: ARENA_COUNT)
+// the compile arenas grow on demand, so a node request only fails once the system is out of memory
+#define node_new(mem, type) ((type*)pool_require(pool_new(pool_segment((mem), ARENA_OF(type)), type)))
+#define node_array(mem, type, count) ((type*)pool_require(pool_array(pool_segment((mem), ARENA_OF(type)), type, (count))))
+// parser built arrays grow as they fill and give back their slack once the node is finished
+#define node_vector(mem, type, v, count) ((type*)pool_require(pool_vector(pool_segment((mem), ARENA_OF(type)), (v), (count), sizeof(type), POOL_ALIGN_OF(type))))
+#define node_trim(mem, type, v, count) pool_trim(pool_segment((mem), ARENA_OF(type)), (v), sizeof(type)*(count), sizeof(type)*pool_vector_capacity(count))
+// declaration lists hold links so entries keep their address while the list grows
+#define declaration_push(mem, type, v, count) (\
+	(v) = (type**)pool_require(pool_vector((mem), (v), (count), sizeof(type*), _Alignof(type*))),\
+	(v)[(count)] = pool_require(pool_new((mem), type)),\
+	(v)[(count)++])
+
+// requests against the compile pool are attributed to whichever phase is current
+typedef enum PHASE_TAG {
+	LEX_PHASE,
+	PARSE_PHASE,
+	ROLL_PHASE,
+	MONOMORPHIZE_PHASE,
+	LIFT_PHASE,
+	PHASE_COUNT
+} PHASE_TAG;
+
+// fixed capacity arrays, grouped by the limit they are sized with
+typedef enum SLOT_TAG {
+	IMPORT_SLOTS,
+	CAPTURE_SLOTS,
+	SLOT_COUNT
+} SLOT_TAG;
+
+typedef struct mem_stats {
+	pool_stats phases;
+	uint64_t slot_arrays[SLOT_COUNT];
+	uint64_t slot_reserved[SLOT_COUNT];
+	uint64_t slot_used[SLOT_COUNT];
+} mem_stats;
+
+void mem_slots(mem_stats* const stats, SLOT_TAG slot, uint64_t capacity, uint64_t used, uint64_t size);
+void mem_report(const ast* const tree, pool* const mem);
+
+// arenas and symbol table kept warm across compilations, each compile leaves them emptied for the next
+typedef struct compiler {
+	pool mem;
+	interner names;
+	mem_stats stats;
+	uint8_t recover;
+	const char* tree_image;
+} compiler;
+
+compiler compiler_init(uint8_t map);
+void compiler_reset(compiler* const c);
+void compiler_free(compiler* const c);
+int compile_file(compiler* const c, char* filename, uint8_t report);
+int compile_cstr(compiler* const c, const char* const name, const char* const buffer, uint64_t read_bytes, uint8_t report);
+
+typedef enum DECLARATION_TAG {
+	TYPE_DECLARATION,
+	ALIAS_DECLARATION,
+	CONSTANT_DECLARATION,
+	FUNCTION_DECLARATION
+} DECLARATION_TAG;
+
+typedef struct declaration_ast {
+	union {
+		new_type_ast new_type;
+		constant_ast constant;
+		function_ast function;
+	} data;
+	DECLARATION_TAG tag;
+} declaration_ast;
 
-ast parse(token* const tokens, pool* const mem, uint64_t token_count, char* string_content_buffer, char* err);
-void add_to_tree(ast* const tree, lexer* const lex, pool* const mem, char* err);
-void parse_import(ast* const tree, lexer* const lex, pool* const mem, char* err);
-uint8_t already_imported(ast* const tree, token filename);
+typedef struct module {
+	token name;
+	source_file source;
+	lexer lex;
+	pool* mem;
+	declaration_ast* decl_v;
+	uint32_t decl_c;
+	uint32_t decl_capacity;
+	uint32_t import_v[MAX_IMPORTS];
+	uint32_t import_c;
+	uint64_t key;
+	uint8_t* cache;
+	uint8_t opened;
+	uint8_t merged;
+	diagnostics diag;
+	line_index lines;
+	char err[ERROR_BUFFER];
+} module;
+
+// each parse worker fills its own arena through pool_local, parse adopts them into the compile pool once the workers join
+typedef struct parse_workers {
+	ast* tree;
+	pool arena_v[MAX_WORKERS];
+	uint8_t map;
+} parse_workers;
+
+ast parse(const char* const buffer, uint64_t size_bytes, pool* const mem, interner* const names, uint8_t recover, char* err);
+module* module_find(ast* const tree, token name);
+void module_discover(ast* const tree, module* const m);
+void module_worker_enter(void* const arg, uint32_t worker);
+void module_worker_leave(void* const arg, uint32_t worker);
+void module_parse_job(void* const arg, uint32_t index);
+void parse_declarations(module* const m);
+void module_merge(ast* const tree, module* const m, pool* const mem, char* err);
+void add_declaration(ast* const tree, declaration_ast* const decl, pool* const mem, char* err);
+void close_modules(ast* const tree);
+source_location module_locate(ast* const tree, source_pos pos);
+uint8_t module_import(ast* const tree, module* const m, token name);
+
+// pointer fields are stored as offsets relative to the field itself, so an image can be loaded at any address
+typedef struct image_header {
+	uint64_t magic;
+	uint64_t key;
+	uint64_t size;
+	uint64_t reloc;
+	uint64_t reloc_c;
+	uint64_t token;
+	uint64_t token_c;
+	uint64_t pos;
+	uint64_t pos_c;
+	uint64_t import;
+	uint64_t import_c;
+	uint64_t root;
+	uint64_t root_c;
+} image_header;
+
+typedef struct image {
+	uint8_t* buffer;
+	uint64_t size;
+	uint64_t capacity;
+	uint64_t* reloc_v;
+	uint64_t reloc_c;
+	uint64_t reloc_capacity;
+	uint64_t* token_v;
+	uint64_t token_c;
+	uint64_t token_capacity;
+	uint64_t* pos_v;
+	uint64_t pos_c;
+	uint64_t pos_capacity;
+} image;
+
+typedef struct ast_image {
+	uint8_t* buffer;
+	uint64_t size;
+} ast_image;
+
+#define IMAGE_AT(img, pos, type) ((type*)((img)->buffer+(pos)))
+#define IMAGE_REF(type, field) ((const type*)image_ref(&(field)))
+
+typedef const void* (*tree_link)(const void* const field);
+
+typedef struct tree_digest {
+	uint32_t declaration_c;
+	uint32_t function_c;
+	uint64_t expression_c;
+	uint64_t type_c;
+	uint64_t hash;
+} tree_digest;
+
+image image_init(void);
+void image_free(image* const img);
+uint64_t image_reserve(image* const img, uint64_t size);
+uint64_t image_bytes(image* const img, const void* const data, uint64_t size);
+void image_mark(uint64_t** const pos_v, uint64_t* const pos_c, uint64_t* const pos_capacity, uint64_t pos);
+void image_link(image* const img, uint64_t field, uint64_t target);
+uint64_t image_pointer(image* const img, uint64_t field, const void* const data, uint64_t size);
+void image_string(image* const img, uint64_t field, const char* const string, uint64_t len);
+void image_token(image* const img, uint64_t pos);
+void image_tokens(image* const img, uint64_t field, const token* const token_v, uint64_t token_c, uint64_t capacity);
+void image_type(image* const img, uint64_t pos);
+void image_structure(image* const img, uint64_t pos);
+void image_binding(image* const img, uint64_t pos);
+void image_statement(image* const img, uint64_t pos);
+void image_literal(image* const img, uint64_t pos);
+void image_expression(image* const img, uint64_t pos);
+void image_function(image* const img, uint64_t pos);
+void image_declaration(image* const img, uint64_t pos);
+uint8_t image_write(image* const img, const char* const filename);
+uint8_t* image_load(const char* const filename, uint64_t key, interner* const names, uint16_t file);
+uint64_t hash_image_key(const char* const buffer, uint64_t size_bytes);
+void cache_path(char* const path, uint64_t key);
+void cache_prune(time_t max_age);
+void cache_store(ast* const tree, module* const m);
+uint8_t ast_image_write(const ast* const tree, const char* const filename);
+const ast* ast_image_open(ast_image* const img, const char* const filename);
+void ast_image_close(ast_image* const img);
+const void* image_ref(const void* const field);
+const void* tree_pointer(const void* const field);
+void digest_mix(tree_digest* const digest, const void* const data, uint64_t size);
+void digest_token(tree_digest* const digest, tree_link link, const token* const tok);
+void digest_type(tree_digest* const digest, tree_link link, const type_ast* const type);
+void digest_structure(tree_digest* const digest, tree_link link, const structure_ast* const structure);
+void digest_binding(tree_digest* const digest, tree_link link, const binding_ast* const binding);
+void digest_expression(tree_digest* const digest, tree_link link, const expression_ast* const expr);
+void digest_function(tree_digest* const digest, tree_link link, const function_ast* const func);
+tree_digest digest_tree(const ast* const tree, tree_link link);
+void show_digest(const char* const label, const tree_digest* const digest);
+uint8_t tree_image_check(const ast* const tree, const char* const filename);
 void parse_type_params(lexer* const lex, pool* const mem, type_ast* const outer);
 type_ast parse_type(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_token, uint8_t consume);
 new_type_ast parse_new_type(lexer* const lex, pool* const mem, char* err);
 constant_ast parse_constant(lexer* const lex, pool* const mem, char* err);
 function_ast parse_function(lexer* const lex, pool* const mem, char* err, uint8_t allowed_enclosing);
 expression_ast parse_lambda(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_token, uint8_t* simple);
+expression_ast parse_group_body(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_token);
 expression_ast parse_application_expression(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_token, uint8_t allow_block, int8_t limit);
 expression_ast parse_block_expression(lexer* const lex, pool* const mem, char* err, TOKEN_TYPE_TAG end_token, expression_ast first);
 expression_ast unwrap_single_application(expression_ast single);
-function_ast try_function(lexer* const lex, pool* const mem, char* err);
+void expression_push(pool* const mem, expression_ast* const outer, expression_ast item);
 structure_ast parse_struct(lexer* const lex, pool* const mem, char* err);
 literal_ast parse_array_literal(lexer* const lex, pool* const mem, char* err);
 binding_ast parse_char_literal(lexer* const lex, pool* const mem, char* err);
 literal_ast parse_string_literal(lexer* const lex, pool* const mem, char* err);
 literal_ast parse_struct_literal(lexer* const lex, pool* const mem, char* err);
+void literal_push(pool* const mem, literal_ast* const lit, expression_ast item);
 
 typedef struct capture_stack {
 	struct capture_stack* prev;
 	struct capture_stack* next;
-	binding_ast binding_list[MAX_CAPTURES];
-	uint16_t size;
-	uint16_t binding_count_point;
+	binding_ast* binding_list;
+	uint32_t capacity;
+	uint32_t size;
+	uint32_t high;
+	uint32_t binding_count_point;
 } capture_stack;
 
 typedef struct replacement_binding {
@@ -468,31 +824,34 @@ typedef struct value_binding {
 	struct value_binding* ref;
 } value_binding;
 
+// stacks start at SCOPE_STACK_MIN entries and double in the scratch segment as they fill
 typedef struct scope {
+	pool* mem;
 	value_binding* binding_stack;
-	uint16_t* frame_stack;
-	uint16_t binding_count;
-	uint16_t binding_capacity;
-	uint16_t frame_count;
-	uint16_t frame_capacity;
+	uint32_t* frame_stack;
+	uint32_t binding_count;
+	uint32_t binding_capacity;
+	uint32_t frame_count;
+	uint32_t frame_capacity;
 	capture_stack* captures;
-	uint16_t capture_frame;
-	uint16_t builtin_stack_frame;
+	uint32_t capture_frame;
+	uint32_t builtin_stack_frame;
 	binding_ast* label_stack;
-	uint16_t label_count;
-	uint16_t label_capacity;
-	uint16_t* label_frame_stack;
-	uint16_t* label_scope_stack;
-	uint16_t label_frame_count;
-	uint16_t label_frame_capacity;
-	uint16_t label_scope_count;
+	uint32_t label_count;
+	uint32_t label_capacity;
+	uint32_t* label_frame_stack;
+	uint32_t* label_scope_stack;
+	uint32_t label_frame_count;
+	uint32_t label_frame_capacity;
+	uint32_t label_scope_count;
+	uint32_t label_scope_capacity;
 } scope;
 
 void push_capture_frame(scope* const roll, pool* const mem);
-uint16_t pop_capture_frame(scope* const roll, binding_ast** list_result);
+uint32_t pop_capture_frame(scope* const roll, binding_ast** list_result);
 void push_capture_binding(scope* const roll, binding_ast binding);
 
-void push_builtins(scope* const roll, pool* const mem);
+void push_builtins(scope* const roll, interner* const names, pool* const mem);
 void push_frame(scope* const s);
 void pop_frame(scope* const s);
 
@@ -518,12 +877,13 @@ type_ast apply_type(type_ast* const func, char* err);
 type_ast resolve_type_or_alias(ast* const tree, type_ast root, char* err);
 type_ast resolve_alias(ast* const tree, type_ast root, char* err);
 void reduce_aliases(ast* const tree, type_ast* left, type_ast* right);
-type_ast prepend_captures(type_ast start, binding_ast* captures, uint16_t total_captures, pool* const mem);
+token* prepend_capture_args(token* const argv, uint32_t argc, binding_ast* captures, uint32_t total_captures, pool* const mem);
+type_ast prepend_captures(type_ast start, binding_ast* captures, uint32_t total_captures, pool* const mem);
 uint64_t primitive_size_helper(PRIMITIVE_TAGS p);
 uint64_t type_size_helper(ast* const tree, type_ast target_type, uint64_t rolling_size, char* err);
 uint64_t struct_size_helper(ast* const tree, structure_ast target_struct, char* err);
 uint64_t type_size(ast* const tree, type_ast target_type, char* err);
-void lift_lambda(ast* const tree, expression_ast* expr, type_ast captured_type, binding_ast* captured_bindings, uint16_t total_captures, pool* const mem);
+void lift_lambda(ast* const tree, expression_ast* expr, type_ast captured_type, binding_ast* captured_bindings, uint32_t total_captures, pool* const mem);
 
 uint8_t type_set_equal(type_ast_map* const assoc, type_ast_map* const candidate, token* const param_v, uint8_t param_c);
 void clash_types(scope* const roll, ast* const tree, pool* const mem, type_ast_map* const assoc, type_ast* const full_type, uint32_t argc, expression_ast* const argv, char* err);
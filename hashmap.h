@@ -1,115 +1,157 @@
 #ifndef HASHMAP_H
 #define HASHMAP_H
 
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "pool.h"
 
-#define MAP_SIZE 128
+#define MAP_GROUP 16
+#define MAP_EMPTY 0x80
+#define MAP_LOAD_NUM 7
+#define MAP_LOAD_DEN 8
 
-inline uint8_t hash_s(const char* key){
-	uint32_t hash = 5381;
-	int16_t c;
-	while ((c=*key++)) hash = ((hash<<5)+hash)+c;
-	return hash%MAP_SIZE;
+// a full slot's control byte holds the top 7 bits of its hash, a group of 16 is compared in one instruction
+static inline uint32_t
+map_group_match(const uint8_t* const group, uint8_t byte){
+#ifdef __SSE2__
+	__m128i control = _mm_loadu_si128((const __m128i*)group);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)byte)));
+#else
+	uint32_t mask = 0;
+	for (uint32_t i = 0;i<MAP_GROUP;++i){
+		mask |= (uint32_t)(group[i] == byte) << i;
+	}
+	return mask;
+#endif
 }
 
-typedef enum BUCKET_TAG {
-	BUCKET_EMPTY,
-	BUCKET_FULL
-} BUCKET_TAG; 
+// murmur3 finalizer, symbol ids are handed out densely so their raw low bits would crowd the first groups
+static inline uint32_t
+map_hash(uint32_t key){
+	key ^= key >> 16;
+	key *= 0x85ebca6b;
+	key ^= key >> 13;
+	key *= 0xc2b2ae35;
+	key ^= key >> 16;
+	return key;
+}
 
+// open addressing over groups of MAP_GROUP slots, probed triangularly so every group is reached once
+// nothing is ever removed, so a group with an empty slot ends a probe and no tombstones are needed
+// tables live in the map's pool, a grown map leaves its old table behind for the pool to reclaim
 #define MAP_DEF(type)\
-struct type##_map_bucket;\
-typedef struct type##_map_bucket{\
-	BUCKET_TAG tag;\
-	const char* key;\
+typedef struct type##_map_slot{\
+	uint32_t key;\
 	type* value;\
-	struct type##_map_bucket* left;\
-	struct type##_map_bucket* right;\
-} type##_map_bucket;\
+} type##_map_slot;\
 \
 typedef struct type##_map{\
 	pool* mem;\
-	type##_map_bucket buckets[MAP_SIZE];\
+	uint8_t* control;\
+	type##_map_slot* slot_v;\
+	uint32_t capacity;\
+	uint32_t count;\
 } type##_map;\
 \
 type##_map type##_map_init(pool* const mem);\
-uint8_t type##_bucket_insert(type##_map_bucket* bucket, pool* const mem, const char* const key, type* value);\
-type* type##_bucket_access(type##_map_bucket* bucket, const char* const key);\
-uint8_t type##_map_insert(type##_map* const m, const char* const key, type* value);\
-type* type##_map_access(type##_map* const m, const char* const key);\
-type* type##_map_access_by_hash(type##_map* const m, uint32_t hash, const char* const key);
+type##_map_slot* type##_map_probe(type##_map* const m, uint32_t key, uint32_t hash, uint8_t* const found);\
+void type##_map_grow(type##_map* const m);\
+uint8_t type##_map_insert(type##_map* const m, uint32_t key, type* value);\
+type* type##_map_access(type##_map* const m, uint32_t key);
 
 
+// probe finds the slot holding key, or claims the empty slot it belongs in and reports found as 0
 #define MAP_IMPL(type)\
 type##_map type##_map_init(pool* const mem){\
 	type##_map m = {\
-		.mem=mem\
+		.mem=mem,\
+		.control=NULL,\
+		.slot_v=NULL,\
+		.capacity=0,\
+		.count=0\
 	};\
-	for (size_t i = 0;i<MAP_SIZE;++i){\
-		m.buckets[i] = (type##_map_bucket){\
-			.tag=BUCKET_EMPTY\
-		};\
-	}\
 	return m;\
 }\
 \
-uint8_t type##_bucket_insert(type##_map_bucket* bucket, pool* const mem, const char* const key, type* value){\
-	if (bucket->tag == BUCKET_EMPTY){\
-		bucket->tag = BUCKET_FULL;\
-		bucket->key = key;\
-		bucket->value = value;\
-		bucket->left = pool_request(mem, sizeof(type##_map_bucket));\
-		bucket->right = pool_request(mem, sizeof(type##_map_bucket));\
-		*bucket->left = (type##_map_bucket){ .tag=BUCKET_EMPTY };\
-		*bucket->right = (type##_map_bucket){ .tag=BUCKET_EMPTY };\
-		return 0;\
+type##_map_slot* type##_map_probe(type##_map* const m, uint32_t key, uint32_t hash, uint8_t* const found){\
+	uint8_t tag = hash >> 25;\
+	uint32_t mask = (m->capacity/MAP_GROUP)-1;\
+	uint32_t group = hash & mask;\
+	for (uint32_t step = 1;;++step){\
+		uint8_t* control = m->control+(group*MAP_GROUP);\
+		for (uint32_t match = map_group_match(control, tag);match != 0;match &= match-1){\
+			type##_map_slot* slot = &m->slot_v[(group*MAP_GROUP)+__builtin_ctz(match)];\
+			if (slot->key == key){\
+				*found = 1;\
+				return slot;\
+			}\
+		}\
+		uint32_t empty = map_group_match(control, MAP_EMPTY);\
+		if (empty != 0){\
+			uint32_t index = __builtin_ctz(empty);\
+			control[index] = tag;\
+			type##_map_slot* slot = &m->slot_v[(group*MAP_GROUP)+index];\
+			slot->key = key;\
+			*found = 0;\
+			return slot;\
+		}\
+		group = (group+step) & mask;\
 	}\
-	int32_t cmp = strncmp(key, bucket->key, TOKEN_MAX);\
-	if (cmp < 0){\
-		return type##_bucket_insert(bucket->left, mem, key, value);\
-	}\
-	if (cmp > 0){\
-		return type##_bucket_insert(bucket->right, mem, key, value);\
-	}\
-	bucket->value = value;\
-	return 1;\
 }\
 \
-type* type##_bucket_access(type##_map_bucket* bucket, const char* const key){\
-	if (bucket->tag == BUCKET_EMPTY){\
-		return NULL;\
-	}\
-	int32_t cmp = strncmp(key, bucket->key, TOKEN_MAX);\
-	if (cmp < 0){\
-		return type##_bucket_access(bucket->left, key);\
+void type##_map_grow(type##_map* const m){\
+	uint8_t* control = m->control;\
+	type##_map_slot* slot_v = m->slot_v;\
+	uint32_t capacity = m->capacity;\
+	m->capacity = capacity == 0 ? MAP_GROUP : capacity*2;\
+	m->control = pool_require(pool_array(m->mem, uint8_t, m->capacity));\
+	m->slot_v = pool_require(pool_array(m->mem, type##_map_slot, m->capacity));\
+	memset(m->control, MAP_EMPTY, m->capacity);\
+	uint8_t found;\
+	for (uint32_t i = 0;i<capacity;++i){\
+		if (control[i] != MAP_EMPTY){\
+			type##_map_probe(m, slot_v[i].key, map_hash(slot_v[i].key), &found)->value = slot_v[i].value;\
+		}\
 	}\
-	if (cmp > 0){\
-		return type##_bucket_access(bucket->right, key);\
-	}\
-	return bucket->value;\
-}\
-\
-uint8_t type##_map_insert(type##_map* const m, const char* const key, type* value){\
-	uint32_t hash = 5381;\
-	int16_t c;\
-	const char* k = key;\
-	while ((c=*k++)) hash = ((hash<<5)+hash)+c;\
-	hash = hash%MAP_SIZE;\
-	return type##_bucket_insert(&m->buckets[hash], m->mem, key, value);\
 }\
 \
-type* type##_map_access(type##_map* const m, const char* const key){\
-	uint32_t hash = 5381;\
-	int16_t c;\
-	const char* k = key;\
-	while ((c=*k++)) hash = ((hash<<5)+hash)+c;\
-	hash = hash%MAP_SIZE;\
-	return type##_bucket_access(&m->buckets[hash], key);\
+uint8_t type##_map_insert(type##_map* const m, uint32_t key, type* value){\
+	if ((m->count+1)*MAP_LOAD_DEN > m->capacity*MAP_LOAD_NUM){\
+		type##_map_grow(m);\
+	}\
+	uint8_t found;\
+	type##_map_slot* slot = type##_map_probe(m, key, map_hash(key), &found);\
+	slot->value = value;\
+	if (found == 0){\
+		m->count += 1;\
+	}\
+	return found;\
 }\
 \
-type* type##_map_access_by_hash(type##_map* const m, uint32_t hash, const char* const key){\
-	hash = hash%MAP_SIZE;\
-	return type##_bucket_access(&m->buckets[hash], key);\
+type* type##_map_access(type##_map* const m, uint32_t key){\
+	if (m->count == 0){\
+		return NULL;\
+	}\
+	uint32_t hash = map_hash(key);\
+	uint8_t tag = hash >> 25;\
+	uint32_t mask = (m->capacity/MAP_GROUP)-1;\
+	uint32_t group = hash & mask;\
+	for (uint32_t step = 1;;++step){\
+		const uint8_t* control = m->control+(group*MAP_GROUP);\
+		for (uint32_t match = map_group_match(control, tag);match != 0;match &= match-1){\
+			type##_map_slot* slot = &m->slot_v[(group*MAP_GROUP)+__builtin_ctz(match)];\
+			if (slot->key == key){\
+				return slot->value;\
+			}\
+		}\
+		if (map_group_match(control, MAP_EMPTY) != 0){\
+			return NULL;\
+		}\
+		group = (group+step) & mask;\
+	}\
 }
 
 
@@ -0,0 +1,91 @@
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "jobs.h"
+
+typedef struct job_queue {
+	job_fn fn;
+	job_worker_fn enter;
+	job_worker_fn leave;
+	void* arg;
+	uint32_t job_c;
+	atomic_uint next;
+} job_queue;
+
+static uint32_t jobs_override = 0;
+
+void jobs_set_workers(uint32_t workers){
+	jobs_override = workers > MAX_WORKERS ? MAX_WORKERS : workers;
+}
+
+uint32_t jobs_workers(void){
+	if (jobs_override != 0){
+		return jobs_override;
+	}
+	long online = sysconf(_SC_NPROCESSORS_ONLN);
+	if (online < 1){
+		return 1;
+	}
+	if (online > MAX_WORKERS){
+		return MAX_WORKERS;
+	}
+	return online;
+}
+
+typedef struct job_worker {
+	job_queue* queue;
+	uint32_t index;
+} job_worker;
+
+void* jobs_worker(void* arg){
+	job_worker* worker = arg;
+	job_queue* queue = worker->queue;
+	if (queue->enter != NULL){
+		queue->enter(queue->arg, worker->index);
+	}
+	for (uint32_t i = atomic_fetch_add(&queue->next, 1);i<queue->job_c;i = atomic_fetch_add(&queue->next, 1)){
+		queue->fn(queue->arg, i);
+	}
+	if (queue->leave != NULL){
+		queue->leave(queue->arg, worker->index);
+	}
+	return NULL;
+}
+
+void jobs_run(job_fn fn, void* const arg, uint32_t job_c, uint32_t worker_c){
+	jobs_run_workers(fn, NULL, NULL, arg, job_c, worker_c);
+}
+
+// enter and leave run once on each worker around the jobs it takes, the calling thread is worker 0
+void jobs_run_workers(job_fn fn, job_worker_fn enter, job_worker_fn leave, void* const arg, uint32_t job_c, uint32_t worker_c){
+	job_queue queue = {
+		.fn=fn,
+		.enter=enter,
+		.leave=leave,
+		.arg=arg,
+		.job_c=job_c
+	};
+	atomic_init(&queue.next, 0);
+	if (worker_c > job_c){
+		worker_c = job_c;
+	}
+	if (worker_c > MAX_WORKERS){
+		worker_c = MAX_WORKERS;
+	}
+	pthread_t threads[MAX_WORKERS];
+	job_worker worker_v[MAX_WORKERS];
+	uint32_t started = 0;
+	for (;started+1<worker_c;++started){
+		worker_v[started+1] = (job_worker){.queue=&queue, .index=started+1};
+		if (pthread_create(&threads[started], NULL, jobs_worker, &worker_v[started+1]) != 0){
+			break;
+		}
+	}
+	worker_v[0] = (job_worker){.queue=&queue, .index=0};
+	jobs_worker(&worker_v[0]);
+	for (uint32_t i = 0;i<started;++i){
+		pthread_join(threads[i], NULL);
+	}
+}
@@ -0,0 +1,16 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <inttypes.h>
+
+#define MAX_WORKERS 64
+
+typedef void (*job_fn)(void* const arg, uint32_t index);
+typedef void (*job_worker_fn)(void* const arg, uint32_t worker);
+
+uint32_t jobs_workers(void);
+void jobs_set_workers(uint32_t workers);
+void jobs_run(job_fn fn, void* const arg, uint32_t job_c, uint32_t worker_c);
+void jobs_run_workers(job_fn fn, job_worker_fn enter, job_worker_fn leave, void* const arg, uint32_t job_c, uint32_t worker_c);
+
+#endif
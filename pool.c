@@ -1,11 +1,13 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
 
 #include "pool.h"
 
 pool pool_alloc(size_t cap, POOL_TAG t){
-	void* mem = malloc(cap);
+	void* mem = calloc(1, cap);
 	if (mem == NULL || t == NO_POOL){
 		return (pool){.tag=NO_POOL};
 	}
@@ -14,44 +16,279 @@ pool pool_alloc(size_t cap, POOL_TAG t){
 		.buffer = mem,
 		.ptr = mem,
 		.left = cap,
-		.next = NULL
+		.next = NULL,
+		.tail = NULL,
+		.grow = cap*2,
+		.segment_v = NULL,
+		.segment_c = 0,
+		.stats = NULL,
+		.request_c = 0,
+		.request_bytes = 0,
+		.used = 0,
+		.high = 0,
+		.mapped = 0,
+		.map = POOL_MAP_NONE,
+		.adopted = NULL
 	};
 }
 
+// anonymous pages for a mapped pool or one of its chunks, cap is rounded up to whole huge pages when map asks for them
+// huge pages fall back to transparent huge pages when none are reserved, the advice only holds for pages not yet touched
+// so that fallback prefaults after advising instead of populating along with the mapping
+void* pool_pages(size_t* const cap, uint8_t map){
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	if (map & POOL_MAP_PREFAULT){
+		flags |= MAP_POPULATE;
+	}
+	if (map & POOL_MAP_HUGE){
+		*cap = (*cap+POOL_HUGE_PAGE-1) & ~(size_t)(POOL_HUGE_PAGE-1);
+		void* mem = mmap(NULL, *cap, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+		if (mem != MAP_FAILED){
+			return mem;
+		}
+		mem = mmap(NULL, *cap, PROT_READ | PROT_WRITE, flags & ~MAP_POPULATE, -1, 0);
+		if (mem == MAP_FAILED){
+			return NULL;
+		}
+		madvise(mem, *cap, MADV_HUGEPAGE);
+		if (map & POOL_MAP_PREFAULT){
+			for (size_t i = 0;i<*cap;i += POOL_HUGE_PAGE){
+				((volatile uint8_t*)mem)[i] = 0;
+			}
+		}
+		return mem;
+	}
+	void* mem = mmap(NULL, *cap, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (mem == MAP_FAILED){
+		return NULL;
+	}
+	return mem;
+}
+
+// backs a pool with anonymous pages instead of the heap, segments split from it and chunks it grows are mapped the same way
+pool pool_map(size_t cap, POOL_TAG t, uint8_t map){
+	if (map == POOL_MAP_NONE){
+		return pool_alloc(cap, t);
+	}
+	if (t == NO_POOL){
+		return (pool){.tag=NO_POOL};
+	}
+	void* mem = pool_pages(&cap, map);
+	if (mem == NULL){
+		return (pool){.tag=NO_POOL};
+	}
+	return (pool){
+		.tag = t,
+		.buffer = mem,
+		.ptr = mem,
+		.left = cap,
+		.next = NULL,
+		.tail = NULL,
+		.grow = cap*2,
+		.segment_v = NULL,
+		.segment_c = 0,
+		.stats = NULL,
+		.request_c = 0,
+		.request_bytes = 0,
+		.used = 0,
+		.high = 0,
+		.mapped = 1,
+		.map = map,
+		.adopted = NULL
+	};
+}
+
+// chunks stay linked as spares for the next fill
 void pool_empty(pool* const p){
-	p->left += p->ptr - p->buffer;
-	p->ptr = p->buffer;
-	if (p->next != NULL){
-		pool_empty(p->next);
+	for (pool* chunk = p;chunk != NULL;chunk = chunk->next){
+		chunk->left += chunk->ptr - chunk->buffer;
+		chunk->ptr = chunk->buffer;
+	}
+	p->tail = NULL;
+	p->used = 0;
+	for (uint32_t i = 0;i<p->segment_c;++i){
+		pool_empty(&p->segment_v[i]);
+	}
+	// adopted storage belongs to whatever was requested before, so it goes with it
+	if (p->adopted != NULL){
+		pool_dealloc(p->adopted);
+		free(p->adopted);
+		p->adopted = NULL;
 	}
 }
 
 void pool_dealloc(pool* const p){
-	free(p->buffer);
-	if (p->next != NULL){
-			pool_dealloc(p->next);
+	if (p->mapped == 1){
+		munmap(p->buffer, p->left + (p->ptr - p->buffer));
+	}
+	else{
+		free(p->buffer);
+	}
+	pool* chunk = p->next;
+	while (chunk != NULL){
+		pool* next = chunk->next;
+		if (chunk->mapped == 1){
+			munmap(chunk, sizeof(pool) + chunk->left + (chunk->ptr - chunk->buffer));
+		}
+		else{
+			free(chunk);
+		}
+		chunk = next;
+	}
+	p->next = NULL;
+	p->tail = NULL;
+	for (uint32_t i = 0;i<p->segment_c;++i){
+		pool_dealloc(&p->segment_v[i]);
+	}
+	free(p->segment_v);
+	p->segment_v = NULL;
+	p->segment_c = 0;
+	if (p->adopted != NULL){
+		pool_dealloc(p->adopted);
+		free(p->adopted);
+		p->adopted = NULL;
 	}
-	free(p->next);
 }
 
 void* pool_request(pool* const p, size_t bytes){
-	if (p->left < bytes){
-		size_t capacity = p->left + (p->ptr-p->buffer);
-		if (p->tag == POOL_STATIC || bytes > capacity){
+	return pool_request_aligned(p, bytes, 1);
+}
+
+// align must be a power of 2
+// a full static pool returns NULL, a dynamic one chains a chunk and only returns NULL when that allocation fails
+// pool_extend and pool_vector pass the NULL on, callers that cannot continue without the memory wrap them in pool_require
+void* pool_request_aligned(pool* const p, size_t bytes, size_t align){
+	pool* tail = p->tail == NULL ? p : p->tail;
+	size_t pad = -(uintptr_t)tail->ptr & (align-1);
+	if (tail->left < pad || tail->left-pad < bytes){
+		if (p->tag != POOL_DYNAMIC){
 			return NULL;
 		}
-		if (p->next == NULL){
-			p->next = malloc(sizeof(pool));
-			*p->next = pool_alloc(p->left + (p->ptr-p->buffer), POOL_DYNAMIC);
+		tail = pool_chunk(p, tail, bytes+align-1);
+		if (tail == NULL){
+			return NULL;
 		}
-		return pool_request(p->next, bytes);
+		p->tail = tail;
+		pad = -(uintptr_t)tail->ptr & (align-1);
+	}
+	tail->left -= pad+bytes;
+	void* addr = tail->ptr+pad;
+	tail->ptr += pad+bytes;
+	p->request_c += 1;
+	p->request_bytes += bytes;
+	p->used += pad+bytes;
+	if (p->used > p->high){
+		p->high = p->used;
+	}
+	if (p->stats != NULL){
+		p->stats->bytes[p->stats->phase] += bytes;
+		p->stats->count[p->stats->phase] += 1;
 	}
-	p->left -= bytes;
-	void* addr = p->ptr;
-	p->ptr += bytes;
 	return addr;
 }
 
+// grows the most recent request in place when its chunk has room, otherwise copies it into a new request
+// the copy keeps the alignment the old address already had, the old storage stays behind until the pool is emptied or rewound
+void* pool_extend(pool* const p, void* const ptr, size_t old, size_t new){
+	pool* tail = p->tail == NULL ? p : p->tail;
+	if (ptr != NULL && (uint8_t*)ptr+old == (uint8_t*)tail->ptr && tail->left >= new-old){
+		tail->left -= new-old;
+		tail->ptr += new-old;
+		p->request_bytes += new-old;
+		p->used += new-old;
+		if (p->used > p->high){
+			p->high = p->used;
+		}
+		if (p->stats != NULL){
+			p->stats->bytes[p->stats->phase] += new-old;
+		}
+		return ptr;
+	}
+	size_t align = (uintptr_t)ptr & -(uintptr_t)ptr;
+	if (ptr == NULL || align > POOL_CACHE_LINE){
+		align = POOL_CACHE_LINE;
+	}
+	void* grown = pool_request_aligned(p, new, align);
+	if (grown != NULL && old != 0){
+		memcpy(grown, ptr, old);
+	}
+	return grown;
+}
+
+// returns an array with room for one more element after count, doubling when count reaches the implied capacity
+void* pool_vector(pool* const p, void* const v, uint64_t count, size_t size, size_t align){
+	if (v == NULL){
+		return pool_request_aligned(p, size*POOL_VECTOR_MIN, align);
+	}
+	if (count < POOL_VECTOR_MIN || (count & (count-1)) != 0){
+		return v;
+	}
+	return pool_extend(p, v, size*count, size*count*2);
+}
+
+uint64_t pool_vector_capacity(uint64_t count){
+	uint64_t capacity = POOL_VECTOR_MIN;
+	while (capacity < count){
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+// gives back the unused end of an array when it is still the most recent request, older arrays keep their size
+void pool_trim(pool* const p, void* const v, size_t used, size_t reserved){
+	pool* tail = p->tail == NULL ? p : p->tail;
+	if (v == NULL || used == 0 || (uint8_t*)v+reserved != (uint8_t*)tail->ptr){
+		return;
+	}
+	tail->ptr -= reserved-used;
+	tail->left += reserved-used;
+	p->used -= reserved-used;
+}
+
+// links a chunk of at least bytes after tail, reusing a spare left by pool_empty or pool_rewind when it fits
+pool* pool_chunk(pool* const p, pool* const tail, size_t bytes){
+	pool* spare = tail->next;
+	if (spare != NULL && spare->left + (spare->ptr-spare->buffer) >= bytes){
+		spare->left += spare->ptr - spare->buffer;
+		spare->ptr = spare->buffer;
+		return spare;
+	}
+	size_t capacity = p->grow;
+	if (bytes > capacity){
+		// oversized requests get a dedicated chunk and leave the growth schedule alone
+		capacity = bytes;
+	}
+	else{
+		p->grow *= 2;
+	}
+	pool* chunk = NULL;
+	if (p->mapped == 1){
+		// prefaulting is for what exists before compiling, a chunk grown mid compile is touched as it fills
+		size_t total = sizeof(pool)+capacity;
+		chunk = pool_pages(&total, p->map & ~POOL_MAP_PREFAULT);
+		capacity = total-sizeof(pool);
+	}
+	else{
+		chunk = calloc(1, sizeof(pool)+capacity);
+	}
+	if (chunk == NULL){
+		return NULL;
+	}
+	*chunk = (pool){
+		.tag = POOL_DYNAMIC,
+		.buffer = chunk+1,
+		.ptr = chunk+1,
+		.left = capacity,
+		.next = spare,
+		.tail = NULL,
+		.grow = 0,
+		.mapped = p->mapped,
+		.map = p->map & ~POOL_MAP_PREFAULT
+	};
+	tail->next = chunk;
+	return chunk;
+}
+
 void* pool_byte(pool* const p){	
 	if (p->left <= 0 || p->tag == POOL_DYNAMIC){
 		return NULL;
@@ -62,20 +299,127 @@ void* pool_byte(pool* const p){
 	return addr;
 }
 
-void pool_save(pool* const p){
-	if (p->next != NULL){
-		pool_save(p->next);
-		return;
+pool_mark pool_checkpoint(pool* const p){
+	pool_mark mark;
+	mark.at[0].tail = p->tail;
+	mark.at[0].ptr = p->tail == NULL ? p->ptr : p->tail->ptr;
+	mark.at[0].used = p->used;
+	for (uint32_t i = 0;i<p->segment_c;++i){
+		pool* segment = &p->segment_v[i];
+		mark.at[i+1].tail = segment->tail;
+		mark.at[i+1].ptr = segment->tail == NULL ? segment->ptr : segment->tail->ptr;
+		mark.at[i+1].used = segment->used;
+	}
+	return mark;
+}
+
+// marks taken later than the one rewound to become invalid, chunks past it are kept as spares
+void pool_rewind(pool* const p, const pool_mark* const mark){
+	pool_seek(p, mark->at[0].tail, mark->at[0].ptr, mark->at[0].used);
+	for (uint32_t i = 0;i<p->segment_c;++i){
+		pool_seek(&p->segment_v[i], mark->at[i+1].tail, mark->at[i+1].ptr, mark->at[i+1].used);
 	}
-	p->ptr_save = p->ptr;
-	p->left_save = p->left;
 }
 
-void pool_load(pool* const p){
-	if (p->next != NULL){
-		pool_load(p);
+void pool_seek(pool* const p, pool* const tail, void* const ptr, uint64_t used){
+	pool* chunk = tail == NULL ? p : tail;
+	chunk->left += chunk->ptr - ptr;
+	chunk->ptr = ptr;
+	p->tail = tail;
+	p->used = used;
+}
+
+// splits off dynamic sub pools so different kinds of allocation can be packed and reset separately
+uint8_t pool_segments(pool* const p, uint32_t count, size_t cap){
+	if (count > POOL_SEGMENT_MAX){
+		return 1;
+	}
+	p->segment_v = malloc(sizeof(pool)*count);
+	if (p->segment_v == NULL){
+		return 1;
+	}
+	for (uint32_t i = 0;i<count;++i){
+		p->segment_v[i] = pool_map(cap, POOL_DYNAMIC, p->map);
+		p->segment_v[i].stats = p->stats;
+	}
+	p->segment_c = count;
+	return 0;
+}
+
+// falls back to the pool itself for kinds without a segment
+pool* pool_segment(pool* const p, uint32_t index){
+	if (index >= p->segment_c || p->segment_v[index].tag == NO_POOL){
+		return p;
+	}
+	return &p->segment_v[index];
+}
+
+// returns the phase being replaced so callers can restore it
+uint32_t pool_phase(pool* const p, uint32_t phase){
+	if (p->stats == NULL){
+		return 0;
+	}
+	uint32_t prev = p->stats->phase;
+	p->stats->phase = phase;
+	return prev;
+}
+
+// restarts the request counters of a pool and its segments against stats, NULL stops phase accounting
+void pool_track(pool* const p, pool_stats* const stats){
+	p->stats = stats;
+	p->request_c = 0;
+	p->request_bytes = 0;
+	p->high = p->used;
+	for (uint32_t i = 0;i<p->segment_c;++i){
+		pool_track(&p->segment_v[i], stats);
+	}
+}
+
+static _Thread_local pool* pool_current = NULL;
+
+// the arena the calling thread allocates from, NULL until one is installed
+pool* pool_local(void){
+	return pool_current;
+}
+
+// workers install the arena they fill while they run, returns the previous one so it can be restored
+pool* pool_local_set(pool* const p){
+	pool* prev = pool_current;
+	pool_current = p;
+	return prev;
+}
+
+// hands everything requested from local to shared, it stays valid until shared is emptied or released
+// local is left without storage. shared is not locked, so adopt from one thread at a time
+void pool_adopt(pool* const shared, pool* const local){
+	if (local->tag == NO_POOL){
 		return;
 	}
-	p->ptr = p->ptr_save;
-	p->left = p->left_save;
+	// nodes already point into local, so there is no way on without an owner for it
+	pool* held = pool_require(malloc(sizeof(pool)));
+	*held = *local;
+	pool* last = held;
+	while (last->adopted != NULL){
+		last = last->adopted;
+	}
+	last->adopted = shared->adopted;
+	shared->adopted = held;
+	*local = (pool){.tag=NO_POOL};
+}
+
+uint32_t pool_chunks(const pool* const p){
+	uint32_t chunks = 0;
+	for (const pool* chunk = p;chunk != NULL;chunk = chunk->next){
+		chunks += 1;
+	}
+	return chunks;
+}
+
+// for callers that cannot go on without their request, ends the process rather than handing back NULL
+void* pool_require(void* const addr){
+	if (addr == NULL){
+		fprintf(stderr, " <!> Out of memory\n");
+		exit(1);
+	}
+	return addr;
 }
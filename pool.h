@@ -3,28 +3,91 @@
 
 #include <inttypes.h>
 
+#define POOL_CACHE_LINE 64
+#define POOL_SEGMENT_MAX 8
+#define POOL_PHASE_MAX 8
+#define POOL_VECTOR_MIN 4
+#define POOL_HUGE_PAGE 0x200000
+
+// nodes of a cache line or more start on a line boundary, smaller ones at their natural alignment
+#define POOL_ALIGN_OF(type) (sizeof(type) >= POOL_CACHE_LINE ? POOL_CACHE_LINE : _Alignof(type))
+#define pool_new(p, type) ((type*)pool_request_aligned((p), sizeof(type), POOL_ALIGN_OF(type)))
+#define pool_array(p, type, count) ((type*)pool_request_aligned((p), sizeof(type)*(count), POOL_ALIGN_OF(type)))
+
 typedef enum POOL_TAG {
 	POOL_STATIC=0,
 	POOL_DYNAMIC=1,
 	NO_POOL
 } POOL_TAG;
 
+// how pool_map backs a pool, flags combine
+typedef enum POOL_MAP_TAG {
+	POOL_MAP_NONE=0,
+	POOL_MAP_HUGE=1,
+	POOL_MAP_PREFAULT=2
+} POOL_MAP_TAG;
+
+// shared by a pool and its segments, requests are counted against whichever phase is current
+typedef struct pool_stats {
+	uint32_t phase;
+	uint64_t bytes[POOL_PHASE_MAX];
+	uint64_t count[POOL_PHASE_MAX];
+} pool_stats;
+
+// dynamic pools chain extra chunks after the head, the head tracks the chunk currently bumped from
 typedef struct pool {
 	POOL_TAG tag;
 	void* buffer;
 	void* ptr;
 	size_t left;
 	struct pool* next;
-	void* ptr_save;
-	size_t left_save;
+	struct pool* tail;
+	size_t grow;
+	struct pool* segment_v;
+	uint32_t segment_c;
+	pool_stats* stats;
+	uint64_t request_c;
+	uint64_t request_bytes;
+	uint64_t used;
+	uint64_t high;
+	uint8_t mapped;
+	uint8_t map;
+	struct pool* adopted;
 } pool;
 
+// a position in a pool and each of its segments, rewinding to it releases everything requested since
+typedef struct pool_mark {
+	struct {
+		struct pool* tail;
+		void* ptr;
+		uint64_t used;
+	} at[POOL_SEGMENT_MAX+1];
+} pool_mark;
+
 pool pool_alloc(size_t cap, POOL_TAG t);
+void* pool_pages(size_t* const cap, uint8_t map);
+pool pool_map(size_t cap, POOL_TAG t, uint8_t map);
 void pool_empty(pool* const p);
 void pool_dealloc(pool* const p);
 void* pool_request(pool* const p, size_t bytes);
+void* pool_request_aligned(pool* const p, size_t bytes, size_t align);
+void* pool_extend(pool* const p, void* const ptr, size_t old, size_t new);
+void* pool_vector(pool* const p, void* const v, uint64_t count, size_t size, size_t align);
+uint64_t pool_vector_capacity(uint64_t count);
+void pool_trim(pool* const p, void* const v, size_t used, size_t reserved);
+pool* pool_chunk(pool* const p, pool* const tail, size_t bytes);
 void* pool_byte(pool* const p);
-void pool_save(pool* const p);
-void pool_load(pool* const p);
+pool_mark pool_checkpoint(pool* const p);
+void pool_rewind(pool* const p, const pool_mark* const mark);
+void pool_seek(pool* const p, pool* const tail, void* const ptr, uint64_t used);
+uint8_t pool_segments(pool* const p, uint32_t count, size_t cap);
+pool* pool_segment(pool* const p, uint32_t index);
+uint32_t pool_phase(pool* const p, uint32_t phase);
+void pool_track(pool* const p, pool_stats* const stats);
+pool* pool_local(void);
+pool* pool_local_set(pool* const p);
+void pool_adopt(pool* const shared, pool* const local);
+uint32_t pool_chunks(const pool* const p);
+void* pool_require(void* const addr);
 
 #endif
@@ -0,0 +1,102 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#define BENCH_MB 1000000.0
+#define BENCH_REPEAT 7
+
+typedef enum BENCH_SOURCE_TAG {
+	BENCH_MIXED,
+	BENCH_LONG_RUNS
+} BENCH_SOURCE_TAG;
+
+static inline double
+bench_now(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec+(t.tv_nsec/1e9);
+}
+
+// runs argv in a child with its output discarded, killed after limit seconds, 0 for no limit
+// returns the wall time, or a negative time when the child did not exit cleanly
+static inline double
+bench_exec(char* const* const argv, uint32_t limit, struct rusage* const usage){
+	double start = bench_now();
+	pid_t pid = fork();
+	if (pid == 0){
+		int null = open("/dev/null", O_WRONLY);
+		dup2(null, 1);
+		dup2(null, 2);
+		alarm(limit);
+		execv(argv[0], argv);
+		_exit(127);
+	}
+	int status;
+	if (pid == -1 || wait4(pid, &status, 0, usage) == -1){
+		fprintf(stderr, "Could not run %s\n", argv[0]);
+		exit(1);
+	}
+	double elapsed = bench_now()-start;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+		return -elapsed;
+	}
+	return elapsed;
+}
+
+// declarations in the shape of ordinary programs, or long identifiers, whitespace and numbers that exercise the vector scans
+static inline int
+bench_entry(char* const out, size_t room, BENCH_SOURCE_TAG kind, uint64_t i){
+	if (kind == BENCH_LONG_RUNS){
+		return snprintf(out, room,
+			"u8 a_really_long_identifier_name_that_keeps_going_on_%" PRIu64 "                                        = 1234567890123456789012345678901234567890;\n",
+			i
+		);
+	}
+	return snprintf(out, room,
+		"// entry %" PRIu64 "\n"
+		"type point%" PRIu64 " {\n"
+		"\tu32 x;\n"
+		"\tu32 y;\n"
+		"\t{u8 r; u8 g; u8 b;} color;\n"
+		"};\n"
+		"\n"
+		"u64 -> u64 scale%" PRIu64 " = \\value (\n"
+		"\tu64 factor = 1234;\n"
+		"\tpoint%" PRIu64 " p = {4, 5, {255, 0, 0}};\n"
+		"\t/* weight the first member */\n"
+		"\treturn value * factor + {p x};\n"
+		");\n"
+		"\n"
+		"constant label%" PRIu64 " = \"name\\t%" PRIu64 "\";\n"
+		"\n",
+		i, i, i, i, i, i
+	);
+}
+
+// at least size bytes of generated source, NUL terminated with the lexer's one byte of lookahead to spare
+static inline char*
+bench_source(BENCH_SOURCE_TAG kind, uint64_t size, uint64_t* const bytes){
+	char* source = malloc(size+1024);
+	if (source == NULL){
+		fprintf(stderr, "Out of memory generating %" PRIu64 " bytes\n", size);
+		exit(1);
+	}
+	uint64_t used = 0;
+	for (uint64_t i = 0;used<size;++i){
+		used += bench_entry(source+used, 1024, kind, i);
+	}
+	source[used] = '\0';
+	*bytes = used;
+	return source;
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include "bench.h"
+
+#define FAULTS_COMPILER "tests/bench/compiler"
+#define FAULTS_SOURCE "tests/bench/faults.ka"
+
+// system wide transparent huge page faults so far, 0 when the kernel does not report them
+static uint64_t
+bench_thp(void){
+	FILE* vmstat = fopen("/proc/vmstat", "r");
+	if (vmstat == NULL){
+		return 0;
+	}
+	char name[64];
+	uint64_t value;
+	uint64_t total = 0;
+	while (fscanf(vmstat, "%63s %" SCNu64, name, &value) == 2){
+		if (strcmp(name, "thp_fault_alloc") == 0){
+			total = value;
+		}
+	}
+	fclose(vmstat);
+	return total;
+}
+
+// one compile in a child process, its rusage carries the page faults of that compile alone
+static void
+bench_compile(char* const* const argv, uint32_t repeat){
+	double best = 1e9;
+	struct rusage best_usage = {0};
+	uint64_t best_thp = 0;
+	for (uint32_t r = 0;r<repeat;++r){
+		uint64_t thp = bench_thp();
+		struct rusage usage;
+		double elapsed = bench_exec(argv, 0, &usage);
+		if (elapsed < 0){
+			fprintf(stderr, "%s exited abnormally\n", argv[0]);
+			exit(1);
+		}
+		if (elapsed < best){
+			best = elapsed;
+			best_usage = usage;
+			best_thp = bench_thp()-thp;
+		}
+	}
+	printf("  wall %.3f s  user %.3f s  sys %.3f s  %7ld faults  %6ld KB rss  %4" PRIu64 " huge pages\n",
+		best,
+		best_usage.ru_utime.tv_sec+(best_usage.ru_utime.tv_usec/1e6),
+		best_usage.ru_stime.tv_sec+(best_usage.ru_stime.tv_usec/1e6),
+		best_usage.ru_minflt,
+		best_usage.ru_maxrss,
+		best_thp
+	);
+}
+
+// page faults and wall time of whole compiles under each arena mapping flag
+// usage: faults [functions] [repeat]
+int
+main(int argc, char** argv){
+	uint64_t function_c = argc > 1 ? strtoull(argv[1], NULL, 10) : 55000;
+	uint32_t repeat = argc > 2 ? strtoul(argv[2], NULL, 10) : 3;
+	FILE* source = fopen(FAULTS_SOURCE, "w");
+	if (source == NULL){
+		fprintf(stderr, "Could not write " FAULTS_SOURCE "\n");
+		return 1;
+	}
+	for (uint64_t i = 0;i<function_c;++i){
+		fprintf(source, "u8 -> u8 fn%" PRIu64 " = \\x (u8 -> u8 g = \\y (y + x); return g x;);\n", i);
+	}
+	fclose(source);
+	char* runs[][5] = {
+		{FAULTS_COMPILER, FAULTS_SOURCE, NULL},
+		{FAULTS_COMPILER, "--prefault", FAULTS_SOURCE, NULL},
+		{FAULTS_COMPILER, "--huge-pages", FAULTS_SOURCE, NULL},
+		{FAULTS_COMPILER, "--huge-pages", "--prefault", FAULTS_SOURCE, NULL}
+	};
+	const char* labels[] = {"no flags", "--prefault", "--huge-pages", "--huge-pages --prefault"};
+	printf("%" PRIu64 " lifted closures, best of %u\n", function_c, repeat);
+	for (uint32_t i = 0;i<4;++i){
+		printf("%s\n", labels[i]);
+		bench_compile(runs[i], repeat);
+	}
+	unlink(FAULTS_SOURCE);
+	return 0;
+}
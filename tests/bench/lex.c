@@ -0,0 +1,43 @@
+#include "bench.h"
+#include "compiler.h"
+#include "pool.h"
+
+// serial lexing throughput, the Makefile builds this against the vector scans and against -DLEX_SCALAR
+// usage: lex <label> [megabytes]
+int
+main(int argc, char** argv){
+	const char* label = argc > 1 ? argv[1] : "lexer";
+	uint64_t size = (argc > 2 ? strtoull(argv[2], NULL, 10) : 8)*BENCH_MB;
+	const char* kind_names[] = {"mixed", "long runs"};
+	for (uint32_t kind = BENCH_MIXED;kind<=BENCH_LONG_RUNS;++kind){
+		uint64_t bytes;
+		char* source = bench_source(kind, size, &bytes);
+		double best = 1e9;
+		uint64_t token_c = 0;
+		for (uint32_t r = 0;r<BENCH_REPEAT;++r){
+			lexer lex = {
+				.source=source,
+				.source_size=bytes,
+				.source_index=0,
+				.err="\0"
+			};
+			token tok;
+			token_c = 0;
+			double start = bench_now();
+			while (lex_next(&lex, &tok) == 1){
+				token_c += 1;
+			}
+			double elapsed = bench_now()-start;
+			if (lex.err[0] != '\0'){
+				fprintf(stderr, "%s", lex.err);
+				return 1;
+			}
+			if (elapsed < best){
+				best = elapsed;
+			}
+		}
+		printf("%-8s %-10s %6.1f MB %9" PRIu64 " tokens  %.4f s  %7.1f MB/s\n", label, kind_names[kind], bytes/BENCH_MB, token_c, best, bytes/best/BENCH_MB);
+		free(source);
+	}
+	return 0;
+}
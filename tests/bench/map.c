@@ -0,0 +1,179 @@
+#include "bench.h"
+#include "hashmap.h"
+
+#define MAP_LIMIT 2.0
+
+typedef struct entry {
+	uint32_t key;
+} entry;
+
+MAP_DEF(entry)
+MAP_IMPL(entry)
+
+// the map before open addressing, kept here as the baseline: 128 inline buckets picked by key%128,
+// each the root of an unbalanced binary tree, so dense symbol ids grow every bucket into a list
+#define TREE_MAP_SIZE 128
+
+typedef enum BUCKET_TAG {
+	BUCKET_EMPTY,
+	BUCKET_FULL
+} BUCKET_TAG;
+
+typedef struct tree_bucket {
+	BUCKET_TAG tag;
+	uint32_t key;
+	entry* value;
+	struct tree_bucket* left;
+	struct tree_bucket* right;
+} tree_bucket;
+
+typedef struct tree_map {
+	pool* mem;
+	tree_bucket buckets[TREE_MAP_SIZE];
+} tree_map;
+
+static void
+tree_map_init(tree_map* const m, pool* const mem){
+	m->mem = mem;
+	for (size_t i = 0;i<TREE_MAP_SIZE;++i){
+		m->buckets[i] = (tree_bucket){.tag=BUCKET_EMPTY};
+	}
+}
+
+static uint8_t
+tree_bucket_insert(tree_bucket* bucket, pool* const mem, uint32_t key, entry* value){
+	if (bucket->tag == BUCKET_EMPTY){
+		bucket->tag = BUCKET_FULL;
+		bucket->key = key;
+		bucket->value = value;
+		bucket->left = pool_require(pool_new(mem, tree_bucket));
+		bucket->right = pool_require(pool_new(mem, tree_bucket));
+		*bucket->left = (tree_bucket){.tag=BUCKET_EMPTY};
+		*bucket->right = (tree_bucket){.tag=BUCKET_EMPTY};
+		return 0;
+	}
+	if (key < bucket->key){
+		return tree_bucket_insert(bucket->left, mem, key, value);
+	}
+	if (key > bucket->key){
+		return tree_bucket_insert(bucket->right, mem, key, value);
+	}
+	bucket->value = value;
+	return 1;
+}
+
+static entry*
+tree_bucket_access(tree_bucket* bucket, uint32_t key){
+	if (bucket->tag == BUCKET_EMPTY){
+		return NULL;
+	}
+	if (key < bucket->key){
+		return tree_bucket_access(bucket->left, key);
+	}
+	if (key > bucket->key){
+		return tree_bucket_access(bucket->right, key);
+	}
+	return bucket->value;
+}
+
+// each run builds map_c maps of key_c dense ids, finds every key and misses as many again
+// returns the number of lookups that disagreed with what was inserted
+static uint64_t
+bench_tree(uint32_t map_c, uint32_t key_c, entry* const value_v, double* const elapsed){
+	pool mem = pool_alloc((size_t)1 << 20, POOL_DYNAMIC);
+	tree_map* m = pool_require(malloc(sizeof(tree_map)));
+	uint64_t wrong = 0;
+	double start = bench_now();
+	for (uint32_t k = 0;k<map_c;++k){
+		tree_map_init(m, &mem);
+		for (uint32_t i = 0;i<key_c;++i){
+			tree_bucket_insert(&m->buckets[i%TREE_MAP_SIZE], m->mem, i, &value_v[i]);
+		}
+		for (uint32_t i = 0;i<key_c;++i){
+			wrong += tree_bucket_access(&m->buckets[i%TREE_MAP_SIZE], i) != &value_v[i];
+		}
+		for (uint32_t i = key_c;i<key_c*2;++i){
+			wrong += tree_bucket_access(&m->buckets[i%TREE_MAP_SIZE], i) != NULL;
+		}
+		pool_empty(&mem);
+	}
+	*elapsed = bench_now()-start;
+	free(m);
+	pool_dealloc(&mem);
+	return wrong;
+}
+
+static uint64_t
+bench_group(uint32_t map_c, uint32_t key_c, entry* const value_v, double* const elapsed){
+	pool mem = pool_alloc((size_t)1 << 20, POOL_DYNAMIC);
+	uint64_t wrong = 0;
+	double start = bench_now();
+	for (uint32_t k = 0;k<map_c;++k){
+		entry_map m = entry_map_init(&mem);
+		for (uint32_t i = 0;i<key_c;++i){
+			entry_map_insert(&m, i, &value_v[i]);
+		}
+		for (uint32_t i = 0;i<key_c;++i){
+			wrong += entry_map_access(&m, i) != &value_v[i];
+		}
+		for (uint32_t i = key_c;i<key_c*2;++i){
+			wrong += entry_map_access(&m, i) != NULL;
+		}
+		pool_empty(&mem);
+	}
+	*elapsed = bench_now()-start;
+	pool_dealloc(&mem);
+	return wrong;
+}
+
+// best of BENCH_REPEAT, the tree map is quadratic in keys per bucket so a run past MAP_LIMIT seconds is not repeated
+static double
+bench_best(uint64_t (*run)(uint32_t, uint32_t, entry* const, double* const), uint32_t map_c, uint32_t key_c, entry* const value_v){
+	double best = 1e9;
+	for (uint32_t r = 0;r<BENCH_REPEAT;++r){
+		double elapsed;
+		if (run(map_c, key_c, value_v, &elapsed) != 0){
+			fprintf(stderr, "map returned a wrong value for %u keys\n", key_c);
+			exit(1);
+		}
+		if (elapsed < best){
+			best = elapsed;
+		}
+		if (elapsed > MAP_LIMIT){
+			break;
+		}
+	}
+	return best;
+}
+
+// inserting, finding and missing dense symbol ids, as the compiler's maps see them,
+// in many small maps like the per call site monomorph maps and in single large ones
+// usage: map [largest key count]
+int
+main(int argc, char** argv){
+	uint32_t max_keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+	entry* value_v = pool_require(malloc(sizeof(entry)*max_keys));
+	for (uint32_t i = 0;i<max_keys;++i){
+		value_v[i].key = i;
+	}
+	uint32_t key_cs[] = {8, 100, 10000, 100000, 1000000};
+	uint32_t map_cs[] = {100000, 10000, 10, 1, 1};
+	uint8_t tree_done = 0;
+	for (uint32_t c = 0;c<sizeof(key_cs)/sizeof(key_cs[0]) && key_cs[c]<=max_keys;++c){
+		double group = bench_best(bench_group, map_cs[c], key_cs[c], value_v);
+		printf("%7u maps of %7u keys  group %8.4f s", map_cs[c], key_cs[c], group);
+		if (tree_done == 1){
+			printf("  tree  skipped\n");
+			continue;
+		}
+		double tree = bench_best(bench_tree, map_cs[c], key_cs[c], value_v);
+		printf("  tree %8.4f s  %7.1fx\n", tree, tree/group);
+		fflush(stdout);
+		// the next size would run for minutes
+		if (tree > MAP_LIMIT){
+			tree_done = 1;
+		}
+	}
+	free(value_v);
+	return 0;
+}
@@ -0,0 +1,66 @@
+#include "bench.h"
+#include "compiler.h"
+#include "pool.h"
+#include "jobs.h"
+
+static double
+bench_cpu(void){
+	struct timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return t.tv_sec+(t.tv_nsec/1e9);
+}
+
+// drains the lexer the way the parser does, interning into the ring and releasing behind itself
+static uint64_t
+bench_drain(const char* const source, uint64_t bytes){
+	interner names = interner_init();
+	lexer lex = lex_init(source, bytes, &names, 0);
+	uint64_t token_c = 0;
+	while (lex_more(&lex) == 1){
+		lex.index += 1;
+		lex_release(&lex);
+		token_c += 1;
+	}
+	if (lex.err[0] != '\0'){
+		fprintf(stderr, "%s", lex.err);
+		exit(1);
+	}
+	lex_close(&lex);
+	interner_free(&names);
+	return token_c;
+}
+
+// parallel lexing against worker count, jobs_set_workers forces the count past what the machine reports
+// usage: parallel [megabytes] [max workers]
+int
+main(int argc, char** argv){
+	uint64_t size = (argc > 1 ? strtoull(argv[1], NULL, 10) : 8)*BENCH_MB;
+	uint32_t max_workers = argc > 2 ? strtoul(argv[2], NULL, 10) : 8;
+	printf("%u online cpus\n", jobs_workers());
+	uint64_t bytes;
+	char* source = bench_source(BENCH_MIXED, size, &bytes);
+	double serial = 0;
+	for (uint32_t workers = 1;workers<=max_workers;workers *= 2){
+		jobs_set_workers(workers);
+		double best = 1e9;
+		double best_cpu = 0;
+		uint64_t token_c = 0;
+		for (uint32_t r = 0;r<BENCH_REPEAT;++r){
+			double start = bench_now();
+			double start_cpu = bench_cpu();
+			token_c = bench_drain(source, bytes);
+			double elapsed = bench_now()-start;
+			if (elapsed < best){
+				best = elapsed;
+				best_cpu = bench_cpu()-start_cpu;
+			}
+		}
+		if (workers == 1){
+			serial = best;
+		}
+		printf("%2u workers %6.1f MB %9" PRIu64 " tokens  wall %.4f s  cpu %.4f s  %.2fx\n", workers, bytes/BENCH_MB, token_c, best, best_cpu, serial/best);
+	}
+	jobs_set_workers(0);
+	free(source);
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include "bench.h"
+
+#define PARSE_SOURCE "tests/bench/parse.ka"
+#define PARSE_LIMIT 20
+
+typedef enum {
+	NEST_BLOCKS,
+	NEST_LAMBDAS,
+	NEST_BRACKETS,
+	NEST_BRACES,
+	NEST_KINDS
+} nest_kind;
+
+// copies of one declaration nested depth deep: blocks binding the block inside them, lambdas returning the lambda inside them, or a dereference or access wrapped depth times
+static void
+bench_nested(FILE* const out, nest_kind kind, uint32_t depth, uint32_t copies){
+	for (uint32_t i = 0;i<copies;++i){
+		if (kind == NEST_BRACKETS || kind == NEST_BRACES){
+			char open = kind == NEST_BRACKETS ? '[' : '{';
+			char close = kind == NEST_BRACKETS ? ']' : '}';
+			fprintf(out, "u8 f%u = (u8 x = 1; return ", i);
+			for (uint32_t d = 0;d<depth;++d){
+				fputc(open, out);
+			}
+			fputc('x', out);
+			for (uint32_t d = 0;d<depth;++d){
+				fputc(close, out);
+			}
+			fprintf(out, ";);\n");
+			continue;
+		}
+		if (kind == NEST_BLOCKS){
+			fprintf(out, "u8 f%u = (", i);
+			for (uint32_t d = depth;d>0;--d){
+				fprintf(out, "u8 v%u = (", d-1);
+			}
+			fprintf(out, "return 1;");
+			for (uint32_t d = 0;d<depth;++d){
+				fprintf(out, "); return v%u;", d);
+			}
+			fprintf(out, ");\n");
+			continue;
+		}
+		fprintf(out, "u8 -> u8 f%u = \\y0 (", i);
+		for (uint32_t d = 1;d<depth;++d){
+			fprintf(out, "u8 -> u8 g%u = \\y%u (", d, d);
+		}
+		fprintf(out, "y0 + 1");
+		for (uint32_t d = depth;d>1;--d){
+			fprintf(out, "); return g%u y%u;", d-1, d-2);
+		}
+		fprintf(out, ");\n");
+	}
+}
+
+// best of 3, a run past PARSE_LIMIT seconds is reported as such and not repeated
+static void
+bench_compiler(char* const compiler){
+	char* argv[] = {compiler, PARSE_SOURCE, NULL};
+	double best = 1e9;
+	for (uint32_t r = 0;r<3;++r){
+		struct rusage usage;
+		double elapsed = bench_exec(argv, PARSE_LIMIT, &usage);
+		if (elapsed < 0){
+			if (-elapsed >= PARSE_LIMIT){
+				printf("  > %u s", PARSE_LIMIT);
+			}
+			else{
+				printf("  %8s", "failed");
+			}
+			return;
+		}
+		if (elapsed < best){
+			best = elapsed;
+		}
+	}
+	printf("  %6.3f s", best);
+}
+
+// whole compiles of deeply nested blocks, lambdas, brackets and braces, each compiler given is run on the same sources
+// the backtracking parser is exponential in bracket and brace depth, so those shapes are a single declaration at shallower depths
+// usage: parse <compiler> [baseline compiler] [copies]
+int
+main(int argc, char** argv){
+	if (argc < 2){
+		fprintf(stderr, "usage: parse <compiler> [baseline compiler] [copies]\n");
+		return 1;
+	}
+	char* baseline = argc > 2 ? argv[2] : NULL;
+	uint32_t copies = argc > 3 ? strtoul(argv[3], NULL, 10) : 100;
+	const char* kinds[NEST_KINDS] = {"blocks", "lambdas", "brackets", "braces"};
+	printf("%u copies of each block and lambda declaration\n", copies);
+	printf("%-8s %5s  %8s%s\n", "nesting", "depth", "current", baseline == NULL ? "" : "  baseline");
+	for (nest_kind kind = NEST_BLOCKS;kind<NEST_KINDS;++kind){
+		uint8_t shallow = kind == NEST_BRACKETS || kind == NEST_BRACES;
+		for (uint32_t depth = shallow ? 12 : 4;depth<=(shallow ? 20 : 64);depth = shallow ? depth+2 : depth*2){
+			FILE* out = fopen(PARSE_SOURCE, "w");
+			if (out == NULL){
+				fprintf(stderr, "Could not write " PARSE_SOURCE "\n");
+				return 1;
+			}
+			bench_nested(out, kind, depth, shallow ? 1 : copies);
+			fclose(out);
+			printf("%-8s %5u", kinds[kind], depth);
+			bench_compiler(argv[1]);
+			if (baseline != NULL){
+				bench_compiler(baseline);
+			}
+			printf("\n");
+			fflush(stdout);
+		}
+	}
+	unlink(PARSE_SOURCE);
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include "bench.h"
+#include "pool.h"
+
+// the pool before chunk lists, kept here as the baseline: each full pool grows one next pool of the same
+// size and a request that does not fit recurses down the whole chain
+typedef struct chain_pool {
+	POOL_TAG tag;
+	char* buffer;
+	char* ptr;
+	size_t left;
+	struct chain_pool* next;
+} chain_pool;
+
+static chain_pool
+chain_alloc(size_t cap, POOL_TAG t){
+	char* mem = malloc(cap);
+	if (mem == NULL){
+		return (chain_pool){.tag=NO_POOL};
+	}
+	return (chain_pool){.tag=t, .buffer=mem, .ptr=mem, .left=cap, .next=NULL};
+}
+
+static void
+chain_dealloc(chain_pool* const p){
+	free(p->buffer);
+	if (p->next != NULL){
+		chain_dealloc(p->next);
+	}
+	free(p->next);
+}
+
+static void*
+chain_request(chain_pool* const p, size_t bytes){
+	if (p->left < bytes){
+		size_t capacity = p->left+(p->ptr-p->buffer);
+		if (p->tag == POOL_STATIC || bytes > capacity){
+			return NULL;
+		}
+		if (p->next == NULL){
+			p->next = malloc(sizeof(chain_pool));
+			*p->next = chain_alloc(capacity, POOL_DYNAMIC);
+		}
+		return chain_request(p->next, bytes);
+	}
+	p->left -= bytes;
+	void* addr = p->ptr;
+	p->ptr += bytes;
+	return addr;
+}
+
+// requests of 8 to 68 bytes in the same pseudo random order for both pools
+static uint64_t
+bench_size(uint64_t* const state){
+	*state = (*state*6364136223846793005ULL)+1442695040888963407ULL;
+	return 8+((*state >> 60) << 2);
+}
+
+static double
+bench_chain(size_t cap, POOL_TAG tag, uint64_t request_c){
+	double best = 1e9;
+	for (uint32_t r = 0;r<BENCH_REPEAT;++r){
+		chain_pool p = chain_alloc(cap, tag);
+		uint64_t state = 12345;
+		double start = bench_now();
+		for (uint64_t i = 0;i<request_c;++i){
+			char* addr = chain_request(&p, bench_size(&state));
+			if (addr != NULL){
+				addr[0] = 1;
+			}
+		}
+		double elapsed = bench_now()-start;
+		chain_dealloc(&p);
+		if (elapsed < best){
+			best = elapsed;
+		}
+		// the chain walk is quadratic, one run of a slow case is enough
+		if (elapsed > 1.0){
+			break;
+		}
+	}
+	return best;
+}
+
+static double
+bench_pool(size_t cap, POOL_TAG tag, uint64_t request_c){
+	double best = 1e9;
+	for (uint32_t r = 0;r<BENCH_REPEAT;++r){
+		pool p = pool_alloc(cap, tag);
+		uint64_t state = 12345;
+		double start = bench_now();
+		for (uint64_t i = 0;i<request_c;++i){
+			char* addr = pool_request(&p, bench_size(&state));
+			if (addr != NULL){
+				addr[0] = 1;
+			}
+		}
+		double elapsed = bench_now()-start;
+		pool_dealloc(&p);
+		if (elapsed < best){
+			best = elapsed;
+		}
+	}
+	return best;
+}
+
+static void
+bench_case(const char* const label, size_t cap, POOL_TAG tag, uint64_t request_c){
+	double chain = bench_chain(cap, tag, request_c);
+	double current = bench_pool(cap, tag, request_c);
+	printf("%-12s %8" PRIu64 " requests  chain %8.4f s  chunk list %.4f s  %7.1fx\n", label, request_c, chain, current, chain/current);
+}
+
+// dynamic pool growth from a small initial size against the old recursive chain
+// usage: pool [largest request count]
+int
+main(int argc, char** argv){
+	uint64_t max_requests = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+	bench_case("static 256M", (size_t)1 << 28, POOL_STATIC, 4000000);
+	const char* labels[] = {"dynamic 1M", "dynamic 64K", "dynamic 4K"};
+	size_t caps[] = {(size_t)1 << 20, (size_t)1 << 16, (size_t)1 << 12};
+	for (uint32_t i = 0;i<3;++i){
+		for (uint64_t request_c = 250000;request_c<=max_requests;request_c *= 4){
+			bench_case(labels[i], caps[i], POOL_DYNAMIC, request_c);
+		}
+	}
+	return 0;
+}
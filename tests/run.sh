@@ -0,0 +1,31 @@
+#!/bin/sh
+# compiles every case in this directory with the flags on its '// args:' line
+# each '// expect:' line must appear in the output and each '// reject:' line must not
+cd "$(dirname "$0")" || exit 1
+failed=0
+for case in *.ka; do
+	args=$(sed -n 's|^// args: ||p' "$case")
+	output=$(../compiler $args "$case" 2>&1)
+	status=0
+	sed -n 's|^// expect: ||p' "$case" > .expect
+	while IFS= read -r line; do
+		if ! printf '%s\n' "$output" | grep -qF -- "$line"; then
+			echo "$case: missing '$line'"
+			status=1
+		fi
+	done < .expect
+	sed -n 's|^// reject: ||p' "$case" > .expect
+	while IFS= read -r line; do
+		if printf '%s\n' "$output" | grep -qF -- "$line"; then
+			echo "$case: unexpected '$line'"
+			status=1
+		fi
+	done < .expect
+	rm -f .expect
+	if [ $status -ne 0 ]; then
+		failed=$((failed+1))
+	else
+		echo "$case ok"
+	fi
+done
+exit $failed